@@ -0,0 +1,744 @@
+/*
+ * OhioSkibidiC Benchmark
+ * Genera programmi .ohio sintetici e misura:
+ *  - Lexer, Parser e Code Generator in-process (il compilatore è incluso qui sotto).
+ *  - End-to-end: l'eseguibile del compilatore lanciato come processo separato.
+ *  - Runtime: i binari generati (solo se nasm e ld sono disponibili).
+ * Con nasm e ld verifica anche l'output del runtime di I/O su casi limite.
+ * Riporta throughput e percentili di latenza e li confronta con una baseline salvata:
+ * se un caso peggiora oltre la tolleranza, il benchmark termina con errore.
+ *
+ * Compilazione:
+ *   gcc -O2 brainrot_compiler2.c -o brainrot_compiler
+ *   gcc -O2 brainrot_bench.c -o brainrot_bench
+ */
+
+#define main ohio_compiler_main
+#include "brainrot_compiler2.c"
+#undef main
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+
+#define MAX_SAMPLES 1000
+#define MAX_BASELINE_ENTRIES 256
+#define DEFAULT_ITERATIONS 10
+#define DEFAULT_TOLERANCE 0.20
+
+// ================================
+// STRUTTURA: Buffer di testo per il generatore
+// ================================
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} TextBuffer;
+
+// Garantisce spazio per length byte più il terminatore
+static void buffer_reserve(TextBuffer* buffer, size_t length) {
+    if (buffer->length + length + 1 > buffer->capacity) {
+        while (buffer->length + length + 1 > buffer->capacity) {
+            buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        }
+        buffer->data = realloc(buffer->data, buffer->capacity);
+        if (!buffer->data) {
+            fprintf(stderr, "Errore: memoria esaurita\n");
+            exit(1);
+        }
+    }
+}
+
+static void buffer_append(TextBuffer* buffer, const char* text, size_t length) {
+    buffer_reserve(buffer, length);
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+static void buffer_printf(TextBuffer* buffer, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+// Formatta direttamente nel buffer: la prima passata misura, la seconda scrive
+static void buffer_printf(TextBuffer* buffer, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (length < 0) return;
+
+    buffer_reserve(buffer, (size_t)length);
+    va_start(args, format);
+    vsnprintf(buffer->data + buffer->length, (size_t)length + 1, format, args);
+    va_end(args);
+    buffer->length += (size_t)length;
+}
+
+// ================================
+// Generatori di corpora sintetici
+// ================================
+typedef struct {
+    const char* name;
+    const char* description;
+    long base_size; // Numero di unità generate con --scale 1
+    void (*generate)(TextBuffer* buffer, long size);
+} Profile;
+
+// Tante dichiarazioni brevi: misura il costo per statement
+static void generate_statements(TextBuffer* buffer, long size) {
+    buffer_printf(buffer, "toiletskibidi main() {\n");
+    for (long i = 0; i < size; i++) {
+        buffer_printf(buffer, "    gyat v%ld = %ld;\n", i % 1000, i);
+    }
+    buffer_printf(buffer, "}\n");
+}
+
+// Identificatori della lunghezza massima ammessa dal lexer
+static void generate_identifiers(TextBuffer* buffer, long size) {
+    char identifier[MAX_TOKEN_LENGTH];
+    buffer_printf(buffer, "toiletskibidi main() {\n");
+    for (long i = 0; i < size; i++) {
+        int prefix = snprintf(identifier, sizeof(identifier), "skibidi%ld", i);
+        for (int j = prefix; j < MAX_TOKEN_LENGTH - 1; j++) {
+            identifier[j] = (char)('a' + (i + j) % 26);
+        }
+        identifier[MAX_TOKEN_LENGTH - 1] = '\0';
+        buffer_printf(buffer, "    gyat %s = %ld;\n", identifier, i);
+    }
+    buffer_printf(buffer, "}\n");
+}
+
+// Molti letterali stringa distinti
+static void generate_strings(TextBuffer* buffer, long size) {
+    buffer_printf(buffer, "toiletskibidi main() {\n");
+    for (long i = 0; i < size; i++) {
+        buffer_printf(buffer, "    yapper(\"rizz numero %ld, ohio level %ld\");\n", i, i % 97);
+    }
+    buffer_printf(buffer, "}\n");
+}
+
+// Blocchi beta annidati fino a una profondità fissa, ripetuti
+static void generate_nesting(TextBuffer* buffer, long size) {
+    const long depth = 1000;
+    buffer_printf(buffer, "toiletskibidi main() {\n    gyat x = 1;\n");
+    for (long done = 0; done < size; done += depth) {
+        for (long i = 0; i < depth; i++) buffer_printf(buffer, "beta (x < %ld) {\n", i + 2);
+        buffer_printf(buffer, "x = x + 1;\n");
+        for (long i = 0; i < depth; i++) buffer_printf(buffer, "} sigma { x = x - 1; }\n");
+    }
+    buffer_printf(buffer, "}\n");
+}
+
+// Espressioni lunghe con tutti gli operatori e parentesi
+static void generate_arithmetic(TextBuffer* buffer, long size) {
+    buffer_printf(buffer, "toiletskibidi main() {\n    gyat a = 7;\n    gyat b = 3;\n    gyat c = 0;\n");
+    for (long i = 0; i < size; i++) {
+        buffer_printf(buffer, "    c = (a + b * %ld - c / 3) * (b - %ld) + a / (b + 1);\n", i % 13 + 1, i % 5);
+    }
+    buffer_printf(buffer, "}\n");
+}
+
+// Cicli edging annidati: pochi statement, molte iterazioni a runtime
+static void generate_loops(TextBuffer* buffer, long size) {
+    buffer_printf(buffer, "toiletskibidi main() {\n    gyat sum = 0;\n");
+    for (long i = 0; i < size; i++) {
+        buffer_printf(buffer,
+            "    gyat i%ld = 0;\n"
+            "    edging (i%ld < 1000) {\n"
+            "        gyat j%ld = 0;\n"
+            "        edging (j%ld < 100) {\n"
+            "            beta (j%ld == 7) { sum = sum - i%ld; } sigma { sum = sum + j%ld * 3; }\n"
+            "            j%ld = j%ld + 1;\n"
+            "        }\n"
+            "        i%ld = i%ld + 1;\n"
+            "    }\n",
+            i, i, i, i, i, i, i, i, i, i, i);
+    }
+    buffer_printf(buffer, "}\n");
+}
+
+// Un solo ciclo che stampa molti interi: misura soprattutto il runtime di yapper
+static void generate_printing(TextBuffer* buffer, long size) {
+    buffer_printf(buffer,
+        "toiletskibidi main() {\n"
+        "    gyat i = 0;\n"
+        "    edging (i < %ld) {\n"
+        "        yapper(\"%%d: %%d\\n\", i, i * 7919 - 1000000);\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "}\n", size);
+}
+
+// Molte funzioni piccole chiamate in un ciclo, più una ricorsione in coda:
+// misura inlining, convenzione di chiamata e chiamate in coda
+static void generate_calls(TextBuffer* buffer, long size) {
+    buffer_printf(buffer,
+        "gyat clamp(gyat x) {\n"
+        "    beta (x > 1000000) { nomilk x - x / 1000000 * 1000000; }\n"
+        "    nomilk x;\n"
+        "}\n"
+        "gyat sum_to(gyat n, gyat acc) {\n"
+        "    beta (n < 1) { nomilk acc; }\n"
+        "    nomilk sum_to(n - 1, acc + n);\n"
+        "}\n");
+    for (long i = 0; i < size; i++) {
+        buffer_printf(buffer, "gyat f%ld(gyat a, gyat b) { nomilk a * %ld + b; }\n", i, i % 7 + 1);
+    }
+    buffer_printf(buffer,
+        "toiletskibidi main() {\n"
+        "    gyat acc = sum_to(100000, 0);\n"
+        "    gyat i = 0;\n"
+        "    edging (i < 1000) {\n");
+    for (long i = 0; i < size; i++) {
+        buffer_printf(buffer, "        acc = clamp(f%ld(acc, i));\n", i);
+    }
+    buffer_printf(buffer,
+        "        i = i + 1;\n"
+        "    }\n"
+        "    yapper(\"%%d\\n\", acc);\n"
+        "}\n");
+}
+
+static const Profile profiles[] = {
+    {"statements",  "dichiarazioni brevi",     200000, generate_statements},
+    {"identifiers", "identificatori lunghi",   100000, generate_identifiers},
+    {"strings",     "letterali stringa",       100000, generate_strings},
+    {"nesting",     "beta/sigma annidati",     100000, generate_nesting},
+    {"arithmetic",  "espressioni aritmetiche", 50000, generate_arithmetic},
+    {"loops",       "cicli edging annidati",       20, generate_loops},
+    {"printing",    "stampa di interi con yapper", 1000000, generate_printing},
+    {"calls",       "funzioni piccole e ricorsione in coda", 2000, generate_calls},
+};
+
+#define PROFILE_COUNT ((int)(sizeof(profiles) / sizeof(profiles[0])))
+
+// ================================
+// Misure e statistiche
+// ================================
+typedef struct {
+    double samples[MAX_SAMPLES]; // Secondi per iterazione
+    int count;
+} Samples;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentile con il metodo nearest-rank (samples già ordinati)
+static double percentile(const Samples* s, double p) {
+    int rank = (int)(p / 100.0 * s->count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > s->count) rank = s->count;
+    return s->samples[rank - 1];
+}
+
+// ================================
+// Fasi misurate
+// ================================
+typedef struct {
+    const char* source_path;
+    const char* asm_path;
+    const char* binary_path;
+    const char* compiler_path;
+    char* source;
+    size_t source_length;
+} BenchCase;
+
+static void phase_lexer(BenchCase* c) {
+    Lexer lexer = create_lexer(c->source);
+    volatile size_t tokens = 0;
+    while (next_token(&lexer).type != TOKEN_EOF) tokens++;
+}
+
+static void phase_parser(BenchCase* c) {
+    Lexer lexer = create_lexer(c->source);
+    free_ast(parse_program(&lexer));
+}
+
+// Il parsing è fuori dalla misura: si cronometra solo la generazione
+static ASTNode* codegen_ast;
+static const CompileOptions default_options = {.profile_mode = PROFILE_NONE};
+
+static void phase_codegen(BenchCase* c) {
+    generate_program(codegen_ast, c->asm_path, &default_options);
+}
+
+// Esegue un processo; input_path e output_path (se non NULL) sostituiscono stdin e stdout
+static int run_process(char* const argv[], const char* input_path, const char* output_path) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        if (input_path) {
+            int input_fd = open(input_path, O_RDONLY);
+            if (input_fd < 0 || dup2(input_fd, STDIN_FILENO) < 0) _exit(127);
+        }
+        if (output_path) {
+            int output_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (output_fd < 0 || dup2(output_fd, STDOUT_FILENO) < 0) _exit(127);
+        }
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static int end_to_end_failed;
+
+static void phase_end_to_end(BenchCase* c) {
+    char* argv[] = {(char*)c->compiler_path, (char*)c->source_path, (char*)c->asm_path, NULL};
+    if (run_process(argv, NULL, "/dev/null") != 0) end_to_end_failed = 1;
+}
+
+static int runtime_failed;
+
+static void phase_runtime(BenchCase* c) {
+    char* argv[] = {(char*)c->binary_path, NULL};
+    if (run_process(argv, NULL, "/dev/null") != 0) runtime_failed = 1;
+}
+
+static void measure(void (*phase)(BenchCase*), BenchCase* c, int iterations, Samples* out) {
+    phase(c); // Riscaldamento: cache e page fault fuori dalla misura
+    out->count = 0;
+    for (int i = 0; i < iterations && i < MAX_SAMPLES; i++) {
+        double start = now_seconds();
+        phase(c);
+        out->samples[out->count++] = now_seconds() - start;
+    }
+    qsort(out->samples, out->count, sizeof(double), compare_doubles);
+}
+
+static int have_assembler(void) {
+    return system("command -v nasm >/dev/null 2>&1 && command -v ld >/dev/null 2>&1") == 0;
+}
+
+// nasm + ld; l'oggetto intermedio è <binary_path>.o
+static int assemble(const char* asm_path, const char* binary_path) {
+    char object_path[512];
+    snprintf(object_path, sizeof(object_path), "%s.o", binary_path);
+
+    char* nasm_argv[] = {"nasm", "-f", "elf64", (char*)asm_path, "-o", object_path, NULL};
+    char* ld_argv[] = {"ld", object_path, "-o", (char*)binary_path, NULL};
+    return run_process(nasm_argv, NULL, NULL) == 0 && run_process(ld_argv, NULL, NULL) == 0;
+}
+
+// Prepara il binario per la fase runtime (nasm e ld già verificati)
+static int build_binary(BenchCase* c) {
+    generate_program(codegen_ast, c->asm_path, &default_options);
+    if (!assemble(c->asm_path, c->binary_path)) {
+        fprintf(stderr, "Errore: assemblaggio del binario di benchmark fallito\n");
+        return 0;
+    }
+    return 1;
+}
+
+// ================================
+// Verifica del runtime di I/O
+// ================================
+// Il runtime di yapper e caseoh_fun è scritto a mano nel .asm: qui si
+// compilano piccoli programmi e se ne confronta l'output con il testo atteso
+
+// Compila ed esegue source con input su stdin; 1 se stdout coincide con expected
+static int check_program(const char* directory, const char* name, const char* source,
+                         const TextBuffer* input, const TextBuffer* expected) {
+    char source_path[256], asm_path[256], binary_path[256], input_path[256], output_path[256], object_path[512];
+    snprintf(source_path, sizeof(source_path), "%s/%s.ohio", directory, name);
+    snprintf(asm_path, sizeof(asm_path), "%s/%s.asm", directory, name);
+    snprintf(binary_path, sizeof(binary_path), "%s/%s.bin", directory, name);
+    snprintf(input_path, sizeof(input_path), "%s/%s.in", directory, name);
+    snprintf(output_path, sizeof(output_path), "%s/%s.out", directory, name);
+    snprintf(object_path, sizeof(object_path), "%s.o", binary_path);
+
+    FILE* file = fopen(input_path, "w");
+    if (!file || fwrite(input->data, 1, input->length, file) != input->length) {
+        perror("Errore nella scrittura dell'input di verifica");
+        if (file) fclose(file);
+        return 0;
+    }
+    fclose(file);
+
+    Lexer lexer = create_lexer(source);
+    ASTNode* program = parse_program(&lexer);
+    CompileOptions options = default_options;
+    options.source_path = source_path;
+    generate_program(program, asm_path, &options);
+    free_ast(program);
+
+    int ok = 0;
+    char* argv[] = {binary_path, NULL};
+    if (!assemble(asm_path, binary_path)) {
+        fprintf(stderr, "Errore: verifica %s: assemblaggio fallito\n", name);
+    } else if (run_process(argv, input_path, output_path) != 0) {
+        fprintf(stderr, "Errore: verifica %s: il programma è terminato con errore\n", name);
+    } else {
+        size_t length = 0;
+        char* output = read_source(output_path, &length);
+        if (output) {
+            size_t common = length < expected->length ? length : expected->length;
+            size_t offset = 0;
+            while (offset < common && output[offset] == expected->data[offset]) offset++;
+            ok = offset == common && length == expected->length;
+            if (!ok) {
+                fprintf(stderr, "Errore: verifica %s: output diverso dal byte %zu (%zu byte, attesi %zu)\n",
+                        name, offset, length, expected->length);
+            }
+            free(output);
+        }
+    }
+
+    unlink(input_path);
+    unlink(output_path);
+    unlink(asm_path);
+    unlink(object_path);
+    unlink(binary_path);
+    return ok;
+}
+
+// __ohio_write_int: cifre a coppie, passaggi 9/10 e 99/100, negativi,
+// INT64_MIN/INT64_MAX e più di 64 KiB di output con righe di lunghezza variabile
+static int check_write_int(const char* directory) {
+    static const long long edges[] = {0, 9, 10, 99, 100, 101, 999999999, 1000000000,
+                                      -1, -9, -10, -99, -100, 9223372036854775807LL};
+    const long lines = 20000;
+    TextBuffer source = {0}, input = {0}, expected = {0};
+
+    buffer_printf(&source, "toiletskibidi main() {\n    gyat i = 0;\n");
+    for (size_t k = 0; k < sizeof(edges) / sizeof(edges[0]); k++) {
+        buffer_printf(&source, "    yapper(\"%%d\\n\", %s%lld);\n", edges[k] < 0 ? "0 - " : "", llabs(edges[k]));
+        buffer_printf(&expected, "%lld\n", edges[k]);
+    }
+    buffer_printf(&source, "    yapper(\"%%d\\n\", 0 - 9223372036854775807 - 1);\n");
+    buffer_printf(&expected, "%lld\n", (long long)INT64_MIN);
+    buffer_printf(&source,
+        "    edging (i < %ld) {\n"
+        "        yapper(\"%%d:%%d|\", i, i * 7919 - 1000000);\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    yapper(\"\\nfine\\n\");\n"
+        "}\n", lines);
+    for (long i = 0; i < lines; i++) buffer_printf(&expected, "%ld:%ld|", i, i * 7919 - 1000000);
+    buffer_printf(&expected, "\nfine\n");
+    buffer_append(&input, "", 0); // Nessun input, ma un buffer valido per fwrite
+
+    int ok = check_program(directory, "check_write_int", source.data, &input, &expected);
+    free(source.data);
+    free(input.data);
+    free(expected.data);
+    return ok;
+}
+
+// __ohio_read_int: più di 64 KiB di input (numeri a cavallo delle riletture),
+// separatori misti, estremi a 64 bit e l'ultimo numero senza a capo finale
+static int check_read_int(const char* directory) {
+    static const char* separators[] = {" ", "\n", "\t  ", "\r\n"};
+    const long count = 30000;
+    TextBuffer input = {0}, expected = {0};
+    const char* source =
+        "toiletskibidi main() {\n"
+        "    gyat n = 0;\n"
+        "    gyat x = 0;\n"
+        "    gyat sum = 0;\n"
+        "    gyat i = 0;\n"
+        "    caseoh_fun(\"%d\", &n);\n"
+        "    edging (i < n) {\n"
+        "        caseoh_fun(\"%d\", &x);\n"
+        "        yapper(\"%d\\n\", x);\n"
+        "        sum = sum + x;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    yapper(\"%d\\n\", sum);\n"
+        "}\n";
+
+    unsigned long long sum = 0; // Aritmetica modulare come nel programma
+    buffer_printf(&input, "%ld\n", count);
+    for (long i = 0; i < count; i++) {
+        long long value;
+        switch (i % 5) {
+            case 0: value = 0; break;
+            case 1: value = i % 10 == 1 ? INT64_MIN : INT64_MAX; break;
+            default: value = (i * 7919 - 1000000) * (i % 3 + 1); break;
+        }
+        buffer_printf(&input, "%lld%s", value, i + 1 < count ? separators[i % 4] : "");
+        buffer_printf(&expected, "%lld\n", value);
+        sum += (unsigned long long)value;
+    }
+    buffer_printf(&expected, "%lld\n", (long long)sum);
+
+    int ok = check_program(directory, "check_read_int", source, &input, &expected);
+    free(input.data);
+    free(expected.data);
+    return ok;
+}
+
+// Statement del sorgente, per la colonna stmt/s
+static long count_source_statements(ASTNode* program) {
+    long count = 0;
+    for (ASTNode* function = program->left; function; function = function->next) {
+        count += count_statements(function->right);
+    }
+    return count;
+}
+
+// ================================
+// Baseline
+// ================================
+// Le fasi che elaborano il sorgente si confrontano in MB/s (più è meglio),
+// il runtime in ms sul p50 (meno è meglio) con chiave "<profilo>/runtime.ms":
+// i byte del sorgente non dicono nulla sul tempo di esecuzione dei binari
+typedef struct {
+    char key[96];  // "<profilo>/<fase>"
+    double value;  // MB/s o ms sul p50, secondo la fase
+} BaselineEntry;
+
+typedef struct {
+    BaselineEntry entries[MAX_BASELINE_ENTRIES];
+    int count;
+} Baseline;
+
+static int load_baseline(const char* path, Baseline* baseline) {
+    FILE* file = fopen(path, "r");
+    baseline->count = 0;
+    if (!file) return 0;
+
+    char line[256];
+    while (fgets(line, sizeof(line), file) && baseline->count < MAX_BASELINE_ENTRIES) {
+        BaselineEntry* entry = &baseline->entries[baseline->count];
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%95s %lf", entry->key, &entry->value) == 2) baseline->count++;
+    }
+    fclose(file);
+    return 1;
+}
+
+static const BaselineEntry* find_baseline(const Baseline* baseline, const char* key) {
+    for (int i = 0; i < baseline->count; i++) {
+        if (strcmp(baseline->entries[i].key, key) == 0) return &baseline->entries[i];
+    }
+    return NULL;
+}
+
+static void record_result(Baseline* results, const char* key, double value) {
+    if (results->count == MAX_BASELINE_ENTRIES) return;
+    BaselineEntry* entry = &results->entries[results->count++];
+    snprintf(entry->key, sizeof(entry->key), "%s", key);
+    entry->value = value;
+}
+
+static int save_baseline(const char* path, const Baseline* results, double scale) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror("Errore nella scrittura della baseline");
+        return 0;
+    }
+    fprintf(file, "# OhioSkibidiC benchmark baseline (scale %g), MB/s sul p50, *.ms in ms sul p50\n", scale);
+    for (int i = 0; i < results->count; i++) {
+        fprintf(file, "%s %.6g\n", results->entries[i].key, results->entries[i].value);
+    }
+    fclose(file);
+    return 1;
+}
+
+// ================================
+// Main del benchmark
+// ================================
+static void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [opzioni]\n"
+        "  --scale <n>            moltiplica la dimensione dei corpora (default 1)\n"
+        "  --iterations <n>       campioni per fase (default %d)\n"
+        "  --profile <nome>       esegue un solo profilo\n"
+        "  --compiler <path>      compilatore per la fase end-to-end (default ./brainrot_compiler)\n"
+        "  --baseline <file>      confronta con la baseline, errore se peggiora\n"
+        "  --save-baseline <file> salva i risultati come nuova baseline\n"
+        "  --tolerance <f>        peggioramento ammesso rispetto alla baseline (default %.2f)\n"
+        "  --keep                 non cancella i corpora generati\n"
+        "Profili:\n",
+        program, DEFAULT_ITERATIONS, DEFAULT_TOLERANCE);
+    for (int p = 0; p < PROFILE_COUNT; p++) {
+        fprintf(stderr, "  %-12s %s (%ld unità con --scale 1)\n",
+                profiles[p].name, profiles[p].description, profiles[p].base_size);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double scale = 1.0;
+    int iterations = DEFAULT_ITERATIONS;
+    const char* only_profile = NULL;
+    const char* compiler_path = "./brainrot_compiler";
+    const char* baseline_path = NULL;
+    const char* save_path = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    int keep = 0;
+
+    for (int i = 1; i < argc; i++) {
+        int has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--scale") == 0 && has_value) scale = atof(argv[++i]);
+        else if (strcmp(argv[i], "--iterations") == 0 && has_value) iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--profile") == 0 && has_value) only_profile = argv[++i];
+        else if (strcmp(argv[i], "--compiler") == 0 && has_value) compiler_path = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && has_value) baseline_path = argv[++i];
+        else if (strcmp(argv[i], "--save-baseline") == 0 && has_value) save_path = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0 && has_value) tolerance = atof(argv[++i]);
+        else if (strcmp(argv[i], "--keep") == 0) keep = 1;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (scale <= 0 || iterations < 1 || iterations > MAX_SAMPLES) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Baseline baseline = {0};
+    if (baseline_path && !load_baseline(baseline_path, &baseline)) {
+        fprintf(stderr, "Errore: baseline '%s' non leggibile\n", baseline_path);
+        return 1;
+    }
+    int have_compiler = access(compiler_path, X_OK) == 0;
+    if (!have_compiler) {
+        fprintf(stderr, "Avviso: '%s' non trovato, fase end-to-end saltata\n", compiler_path);
+    }
+    int have_tools = have_assembler();
+    if (!have_tools) {
+        fprintf(stderr, "Avviso: nasm o ld non trovati, fase runtime e verifica del runtime di I/O saltate\n");
+    }
+
+    char directory[] = "/tmp/ohio_bench_XXXXXX";
+    if (!mkdtemp(directory)) {
+        perror("Errore nella creazione della directory temporanea");
+        return 1;
+    }
+
+    static Baseline results;
+    int regressions = 0;
+
+    if (have_tools) {
+        int passed = check_write_int(directory) + check_read_int(directory);
+        printf("Verifica del runtime di I/O: %d/2 programmi corretti\n\n", passed);
+        regressions += 2 - passed;
+    }
+
+    printf("%-12s %-10s %10s %10s %10s %10s %12s\n",
+           "profilo", "fase", "p50 ms", "p90 ms", "p99 ms", "MB/s", "stmt/s");
+
+    for (int p = 0; p < PROFILE_COUNT; p++) {
+        const Profile* profile = &profiles[p];
+        if (only_profile && strcmp(only_profile, profile->name) != 0) continue;
+
+        long size = (long)(profile->base_size * scale);
+        if (size < 1) size = 1;
+
+        TextBuffer buffer = {0};
+        profile->generate(&buffer, size);
+
+        char source_path[256], asm_path[256], binary_path[256];
+        snprintf(source_path, sizeof(source_path), "%s/%s.ohio", directory, profile->name);
+        snprintf(asm_path, sizeof(asm_path), "%s/%s.asm", directory, profile->name);
+        snprintf(binary_path, sizeof(binary_path), "%s/%s.bin", directory, profile->name);
+
+        FILE* file = fopen(source_path, "w");
+        if (!file || fwrite(buffer.data, 1, buffer.length, file) != buffer.length) {
+            perror("Errore nella scrittura del corpus");
+            return 1;
+        }
+        fclose(file);
+
+        BenchCase c = {source_path, asm_path, binary_path, compiler_path, buffer.data, buffer.length};
+        Lexer lexer = create_lexer(c.source);
+        codegen_ast = parse_program(&lexer);
+        long statements = count_source_statements(codegen_ast);
+
+        struct {
+            const char* name;
+            void (*run)(BenchCase*);
+            int enabled;
+            int source_bound; // Il tempo dipende dal sorgente, non dall'esecuzione
+        } phases[] = {
+            {"lexer", phase_lexer, 1, 1},
+            {"parser", phase_parser, 1, 1},
+            {"codegen", phase_codegen, 1, 1},
+            {"end2end", phase_end_to_end, have_compiler, 1},
+            {"runtime", phase_runtime, have_tools && build_binary(&c), 0},
+        };
+
+        for (size_t f = 0; f < sizeof(phases) / sizeof(phases[0]); f++) {
+            if (!phases[f].enabled) continue;
+
+            static Samples samples;
+            end_to_end_failed = runtime_failed = 0;
+            measure(phases[f].run, &c, iterations, &samples);
+            if (end_to_end_failed || runtime_failed) {
+                fprintf(stderr, "Errore: %s/%s terminato con errore\n", profile->name, phases[f].name);
+                regressions++;
+                continue;
+            }
+
+            double p50 = percentile(&samples, 50);
+            double throughput = buffer.length / 1e6 / p50;
+            printf("%-12s %-10s %10.3f %10.3f %10.3f ",
+                   profile->name, phases[f].name,
+                   p50 * 1e3, percentile(&samples, 90) * 1e3, percentile(&samples, 99) * 1e3);
+            if (phases[f].source_bound) {
+                printf("%10.1f %12.0f\n", throughput, statements / p50);
+            } else {
+                printf("%10s %12s\n", "-", "-");
+            }
+
+            char key[96];
+            snprintf(key, sizeof(key), "%s/%s%s", profile->name, phases[f].name, phases[f].source_bound ? "" : ".ms");
+            const BaselineEntry* reference = find_baseline(&baseline, key);
+            if (phases[f].source_bound) {
+                record_result(&results, key, throughput);
+                if (reference && throughput < reference->value * (1.0 - tolerance)) {
+                    fprintf(stderr, "REGRESSIONE: %s %.1f MB/s contro %.1f MB/s della baseline (-%.0f%%)\n",
+                            key, throughput, reference->value,
+                            100.0 * (1.0 - throughput / reference->value));
+                    regressions++;
+                }
+            } else {
+                record_result(&results, key, p50 * 1e3);
+                if (reference && p50 * 1e3 > reference->value * (1.0 + tolerance)) {
+                    fprintf(stderr, "REGRESSIONE: %s %.3f ms contro %.3f ms della baseline (+%.0f%%)\n",
+                            key, p50 * 1e3, reference->value,
+                            100.0 * (p50 * 1e3 / reference->value - 1.0));
+                    regressions++;
+                }
+            }
+        }
+
+        free_ast(codegen_ast);
+        free(buffer.data);
+        if (!keep) {
+            char object_path[512];
+            snprintf(object_path, sizeof(object_path), "%s.o", binary_path);
+            unlink(source_path);
+            unlink(asm_path);
+            unlink(binary_path);
+            unlink(object_path);
+        }
+    }
+
+    if (!keep) rmdir(directory);
+    else printf("\nCorpora conservati in %s\n", directory);
+
+    if (save_path && !save_baseline(save_path, &results, scale)) return 1;
+    if (regressions) {
+        fprintf(stderr, "%d regressioni rispetto alla baseline\n", regressions);
+        return 1;
+    }
+    return 0;
+}
@@ -12,8 +12,24 @@
 #include <ctype.h>
 
 #define MAX_TOKEN_LENGTH 64
-#define MAX_SOURCE_LENGTH 1024
-#define MAX_MESSAGE_COUNT 100
+#define INITIAL_MESSAGE_CAPACITY 16
+#define INITIAL_SYMBOL_CAPACITY 64
+#define IO_BUFFER_SIZE 65536       // Buffer di stdout e stdin del runtime
+#define FNV_OFFSET_BASIS 1469598103934665603ULL
+#define FNV_PRIME 1099511628211ULL
+
+#define DEFAULT_PROFILE_PATH "default.ohioprof"
+#define PROFILE_MAGIC "OHIOPROF"
+#define PROFILE_HEADER_SIZE 24     // Magic, numero di contatori, checksum
+#define PROFILE_COLD_RATIO 100     // Freddo: eseguito almeno 100 volte meno dell'alternativa
+#define UNROLL_MIN_TRIP_COUNT 4    // Iterazioni medie per srotolare di 2...
+#define UNROLL4_MIN_TRIP_COUNT 16  // ...e di 4
+#define UNROLL_MAX_STATEMENTS 8    // Solo i corpi piccoli vengono duplicati
+
+#define MAX_CALL_ARGUMENTS 6       // Passati in rdi, rsi, rdx, rcx, r8, r9
+#define INLINE_MAX_NODES 12        // Dimensione massima di un'espressione da espandere inline...
+#define INLINE_HOT_MAX_NODES 48    // ...e per le funzioni calde secondo il profilo
+#define INLINE_HOT_MIN_CALLS 1000  // Chiamate registrate perché una funzione sia calda
 
 // ================================
 // ENUM: Tipi di Token
@@ -74,6 +90,8 @@ typedef enum {
 typedef struct {
     TokenType type;
     char value[MAX_TOKEN_LENGTH];
+    int line;   // Posizione nel sorgente .ohio (da 1)
+    int column;
 } Token;
 
 // ================================
@@ -83,6 +101,10 @@ typedef struct {
     const char* source;
     size_t pos;
     size_t length;
+    int line;           // Riga corrente
+    size_t line_start;  // Offset del primo carattere della riga corrente
+    Token lookahead;    // Ultimo token analizzato, ancora da consumare se has_lookahead
+    int has_lookahead;
 } Lexer;
 
 // ================================
@@ -97,7 +119,11 @@ typedef enum {
     NODE_FOR_LOOP,
     NODE_FUNCTION_CALL,
     NODE_LITERAL,
-    NODE_IDENTIFIER
+    NODE_IDENTIFIER,
+    NODE_BINARY_OP,
+    NODE_STRING,
+    NODE_FUNCTION,     // Definizione: left = parametri, right = corpo
+    NODE_RETURN
 } NodeType;
 
 typedef struct ASTNode {
@@ -105,92 +131,151 @@ typedef struct ASTNode {
     char value[MAX_TOKEN_LENGTH]; // Per valori come nomi o numeri
     struct ASTNode* left;
     struct ASTNode* right;
+    struct ASTNode* alternate;    // Ramo sigma (else) di un beta
     struct ASTNode* next;
+    int profile_id;               // Primo contatore del profilo, -1 se assente
+    int line;                     // Posizione nel sorgente, 0 se sconosciuta
+    int column;
 } ASTNode;
 
 // ================================
 // Funzioni Lexer
 // ================================
 Lexer create_lexer(const char* source) {
-    Lexer lexer = {source, 0, strlen(source)};
+    Lexer lexer = {.source = source, .length = strlen(source), .line = 1};
     return lexer;
 }
 
-Token next_token(Lexer* lexer) {
+// Copia un lessema nel token, rifiutando quelli che non ci stanno
+static void copy_lexeme(Token* token, const char* start, size_t length) {
+    if (length >= MAX_TOKEN_LENGTH) {
+        fprintf(stderr, "Errore (riga %d, colonna %d): token troppo lungo (massimo %d caratteri)\n",
+                token->line, token->column, MAX_TOKEN_LENGTH - 1);
+        exit(1);
+    }
+    memcpy(token->value, start, length);
+    token->value[length] = '\0';
+}
+
+static void advance_line(Lexer* lexer) {
+    lexer->line++;
+    lexer->line_start = lexer->pos + 1;
+}
+
+static void set_token(Token* token, TokenType type, const char* text) {
+    token->type = type;
+    strcpy(token->value, text);
+}
+
+// Analizza il prossimo token direttamente nella destinazione, senza copie intermedie
+static void scan_token(Lexer* lexer, Token* token) {
     while (lexer->pos < lexer->length) {
         char current = lexer->source[lexer->pos];
 
         if (isspace(current)) {
+            if (current == '\n') advance_line(lexer);
             lexer->pos++;
             continue;
         }
 
+        token->line = lexer->line;
+        token->column = (int)(lexer->pos - lexer->line_start) + 1;
+
         if (isdigit(current)) {
-            Token token = {TOKEN_NUMBER, {0}};
+            token->type = TOKEN_NUMBER;
             size_t start = lexer->pos;
             while (isdigit(lexer->source[lexer->pos])) lexer->pos++;
-            strncpy(token.value, lexer->source + start, lexer->pos - start);
-            return token;
+            copy_lexeme(token, lexer->source + start, lexer->pos - start);
+            return;
         }
 
-        if (isalpha(current)) {
-            Token token = {TOKEN_IDENTIFIER, {0}};
+        if (isalpha(current) || current == '_') {
+            token->type = TOKEN_IDENTIFIER;
             size_t start = lexer->pos;
-            while (isalnum(lexer->source[lexer->pos])) lexer->pos++;
-            strncpy(token.value, lexer->source + start, lexer->pos - start);
+            while (isalnum(lexer->source[lexer->pos]) || lexer->source[lexer->pos] == '_') lexer->pos++;
+            copy_lexeme(token, lexer->source + start, lexer->pos - start);
 
-            if (strcmp(token.value, "gyat") == 0) token.type = TOKEN_GYAT;
-            else if (strcmp(token.value, "grimace") == 0) token.type = TOKEN_RIZZ;
-            else if (strcmp(token.value, "yap") == 0) token.type = TOKEN_YAP;
-            else if (strcmp(token.value, "caseoh") == 0) token.type = TOKEN_CASEOH;
-            else if (strcmp(token.value, "toiletskibidi") == 0) token.type = TOKEN_TOILETSKIBIDI;
-            else if (strcmp(token.value, "beta") == 0) token.type = TOKEN_BETA;
-            else if (strcmp(token.value, "sigma") == 0) token.type = TOKEN_SIGMA;
-            else if (strcmp(token.value, "yapper") == 0) token.type = TOKEN_YAPPER;
-            return token;
+            if (strcmp(token->value, "gyat") == 0) token->type = TOKEN_GYAT;
+            else if (strcmp(token->value, "grimace") == 0) token->type = TOKEN_RIZZ;
+            else if (strcmp(token->value, "yap") == 0) token->type = TOKEN_YAP;
+            else if (strcmp(token->value, "caseoh") == 0) token->type = TOKEN_CASEOH;
+            else if (strcmp(token->value, "toiletskibidi") == 0) token->type = TOKEN_TOILETSKIBIDI;
+            else if (strcmp(token->value, "beta") == 0) token->type = TOKEN_BETA;
+            else if (strcmp(token->value, "sigma") == 0) token->type = TOKEN_SIGMA;
+            else if (strcmp(token->value, "edging") == 0) token->type = TOKEN_EDGING;
+            else if (strcmp(token->value, "nomilk") == 0) token->type = TOKEN_NOMILK;
+            else if (strcmp(token->value, "yapper") == 0) token->type = TOKEN_YAPPER;
+            else if (strcmp(token->value, "caseoh_fun") == 0) token->type = TOKEN_CASEOH_FUN;
+            return;
         }
 
         if (current == '"') { // Stringhe
             lexer->pos++; // Salta il carattere iniziale "
-            Token token = {TOKEN_STRING, {0}};
+            token->type = TOKEN_STRING;
             size_t start = lexer->pos;
             while (lexer->source[lexer->pos] != '"' && lexer->pos < lexer->length) {
+                if (lexer->source[lexer->pos] == '\n') advance_line(lexer);
+                if (lexer->source[lexer->pos] == '\\' && lexer->pos + 1 < lexer->length) lexer->pos++; // Sequenza di escape
                 lexer->pos++;
             }
             if (lexer->source[lexer->pos] == '"') {
-                strncpy(token.value, lexer->source + start, lexer->pos - start);
+                copy_lexeme(token, lexer->source + start, lexer->pos - start);
                 lexer->pos++; // Salta il carattere finale "
-                return token;
+                return;
             } else {
-                fprintf(stderr, "Errore: stringa non terminata\n");
+                fprintf(stderr, "Errore (riga %d, colonna %d): stringa non terminata\n", token->line, token->column);
                 exit(1);
             }
         }
 
         lexer->pos++;
         switch (current) {
-            case '(' : return (Token){TOKEN_LPAREN, "("};
-            case ')' : return (Token){TOKEN_RPAREN, ")"};
-            case '{' : return (Token){TOKEN_LBRACE, "{"};
-            case '}' : return (Token){TOKEN_RBRACE, "}"};
-            case ';' : return (Token){TOKEN_SEMICOLON, ";"};
-            case '=' : {
+            case '(' : set_token(token, TOKEN_LPAREN, "("); return;
+            case ')' : set_token(token, TOKEN_RPAREN, ")"); return;
+            case '{' : set_token(token, TOKEN_LBRACE, "{"); return;
+            case '}' : set_token(token, TOKEN_RBRACE, "}"); return;
+            case ';' : set_token(token, TOKEN_SEMICOLON, ";"); return;
+            case '=' :
                 if (lexer->source[lexer->pos] == '=') {
                     lexer->pos++;
-                    return (Token){TOKEN_EQ, "=="};
+                    set_token(token, TOKEN_EQ, "==");
+                } else {
+                    set_token(token, TOKEN_ASSIGN, "=");
                 }
-                return (Token){TOKEN_ASSIGN, "="};
-            }
-            case '<' : return (Token){TOKEN_LT, "<"};
-            case '>' : return (Token){TOKEN_GT, ">"};
-            case ',' : return (Token){TOKEN_COMMA, ","};
+                return;
+            case '+' : set_token(token, TOKEN_PLUS, "+"); return;
+            case '-' : set_token(token, TOKEN_MINUS, "-"); return;
+            case '*' : set_token(token, TOKEN_MULTIPLY, "*"); return;
+            case '/' : set_token(token, TOKEN_DIVIDE, "/"); return;
+            case '<' : set_token(token, TOKEN_LT, "<"); return;
+            case '>' : set_token(token, TOKEN_GT, ">"); return;
+            case ',' : set_token(token, TOKEN_COMMA, ","); return;
+            case '&' : set_token(token, TOKEN_AMPERSAND, "&"); return;
             default:
-                fprintf(stderr, "Unrecognized character: %c\n", current);
+                fprintf(stderr, "Unrecognized character: %c (riga %d, colonna %d)\n",
+                        current, token->line, token->column);
                 exit(1);
         }
     }
 
-    return (Token){TOKEN_EOF, ""};
+    token->line = lexer->line;
+    token->column = (int)(lexer->pos - lexer->line_start) + 1;
+    set_token(token, TOKEN_EOF, "");
+}
+
+Token next_token(Lexer* lexer) {
+    if (!lexer->has_lookahead) scan_token(lexer, &lexer->lookahead);
+    lexer->has_lookahead = 0;
+    return lexer->lookahead;
+}
+
+// Legge il prossimo token senza consumarlo: viene analizzato una volta sola
+Token peek_token(Lexer* lexer) {
+    if (!lexer->has_lookahead) {
+        scan_token(lexer, &lexer->lookahead);
+        lexer->has_lookahead = 1;
+    }
+    return lexer->lookahead;
 }
 
 // ================================
@@ -200,53 +285,190 @@ ASTNode* create_ast_node(NodeType type, const char* value) {
     ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
     node->type = type;
     strncpy(node->value, value, MAX_TOKEN_LENGTH);
-    node->left = node->right = node->next = NULL;
+    node->left = node->right = node->alternate = node->next = NULL;
+    node->profile_id = -1;
+    node->line = node->column = 0;
+    return node;
+}
+
+// Crea un nodo che porta valore e posizione del token
+static ASTNode* create_node_from_token(NodeType type, Token token) {
+    ASTNode* node = create_ast_node(type, token.value);
+    node->line = token.line;
+    node->column = token.column;
     return node;
 }
 
-// Parsing di una funzione con più argomenti
-ASTNode* parse_function_call(Lexer* lexer) {
-    Token token = next_token(lexer); // Nome della funzione
-    ASTNode* node = create_ast_node(NODE_FUNCTION_CALL, token.value);
+// Libera un AST; le liste di statement sono percorse in modo iterativo
+void free_ast(ASTNode* node) {
+    while (node) {
+        ASTNode* next = node->next;
+        free_ast(node->left);
+        free_ast(node->right);
+        free_ast(node->alternate);
+        free(node);
+        node = next;
+    }
+}
 
-    token = next_token(lexer); // (
+ASTNode* parse_expression(Lexer* lexer);
+
+// Parsing di una funzione con più argomenti (il nome è già stato letto)
+ASTNode* parse_function_call(Lexer* lexer, Token name) {
+    ASTNode* node = create_node_from_token(NODE_FUNCTION_CALL, name);
+
+    Token token = next_token(lexer); // (
     if (token.type != TOKEN_LPAREN) {
-        fprintf(stderr, "Errore di sintassi: '(' atteso dopo %s\n", node->value);
+        fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): '(' atteso dopo %s, trovato '%s'\n",
+                token.line, token.column, node->value, token.value);
         exit(1);
     }
 
     ASTNode* arg_head = NULL;
     ASTNode* arg_current = NULL;
 
-    while (1) {
-        token = next_token(lexer);
-        if (token.type == TOKEN_RPAREN) break;
+    if (peek_token(lexer).type == TOKEN_RPAREN) {
+        next_token(lexer);
+    } else {
+        while (1) {
+            // caseoh_fun accetta &variabile come in C: la variabile è comunque passata per nome
+            if (peek_token(lexer).type == TOKEN_AMPERSAND) {
+                Token ampersand = next_token(lexer);
+                if (name.type != TOKEN_CASEOH_FUN) {
+                    fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): '&' ammesso solo negli argomenti di caseoh_fun\n",
+                            ampersand.line, ampersand.column);
+                    exit(1);
+                }
+            }
 
-        ASTNode* arg = create_ast_node(NODE_LITERAL, token.value);
-        if (!arg_head) {
-            arg_head = arg;
-        } else {
-            arg_current->next = arg;
-        }
-        arg_current = arg;
+            ASTNode* arg = parse_expression(lexer);
+            if (!arg_head) {
+                arg_head = arg;
+            } else {
+                arg_current->next = arg;
+            }
+            arg_current = arg;
 
-        token = next_token(lexer);
-        if (token.type == TOKEN_RPAREN) break;
+            token = next_token(lexer);
+            if (token.type == TOKEN_RPAREN) break;
 
-        if (token.type != TOKEN_COMMA) {
-            fprintf(stderr, "Errore di sintassi: ',' o ')' atteso\n");
-            exit(1);
+            if (token.type != TOKEN_COMMA) {
+                fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): ',' o ')' atteso, trovato '%s'\n",
+                        token.line, token.column, token.value);
+                exit(1);
+            }
         }
     }
 
     node->left = arg_head;
+    return node;
+}
 
-    token = next_token(lexer); // ;
-    if (token.type != TOKEN_SEMICOLON) {
-        fprintf(stderr, "Errore di sintassi: ';' atteso dopo chiamata a funzione\n");
+// Consuma un token del tipo atteso o termina con un errore di sintassi
+static Token expect_token(Lexer* lexer, TokenType type, const char* expected) {
+    Token token = next_token(lexer);
+    if (token.type != type) {
+        fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): %s atteso, trovato '%s'\n",
+                token.line, token.column, expected, token.value);
         exit(1);
     }
+    return token;
+}
+
+static ASTNode* create_binary_node(Token op, ASTNode* left, ASTNode* right) {
+    ASTNode* node = create_node_from_token(NODE_BINARY_OP, op);
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+// primario: numero | stringa | identificatore | chiamata | ( espressione ) | - primario
+static ASTNode* parse_primary(Lexer* lexer) {
+    Token token = next_token(lexer);
+    switch (token.type) {
+        case TOKEN_NUMBER:
+            return create_node_from_token(NODE_LITERAL, token);
+        case TOKEN_STRING:
+            return create_node_from_token(NODE_STRING, token);
+        case TOKEN_IDENTIFIER:
+            if (peek_token(lexer).type == TOKEN_LPAREN) return parse_function_call(lexer, token);
+            return create_node_from_token(NODE_IDENTIFIER, token);
+        case TOKEN_LPAREN: {
+            ASTNode* inner = parse_expression(lexer);
+            expect_token(lexer, TOKEN_RPAREN, "')'");
+            return inner;
+        }
+        case TOKEN_MINUS:
+            return create_binary_node(token, create_ast_node(NODE_LITERAL, "0"), parse_primary(lexer));
+        default:
+            fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): espressione attesa, trovato '%s'\n",
+                    token.line, token.column, token.value);
+            exit(1);
+    }
+}
+
+// termine: primario (('*' | '/') primario)*
+static ASTNode* parse_term(Lexer* lexer) {
+    ASTNode* node = parse_primary(lexer);
+    TokenType type = peek_token(lexer).type;
+    while (type == TOKEN_MULTIPLY || type == TOKEN_DIVIDE) {
+        Token op = next_token(lexer);
+        node = create_binary_node(op, node, parse_primary(lexer));
+        type = peek_token(lexer).type;
+    }
+    return node;
+}
+
+// somma: termine (('+' | '-') termine)*
+static ASTNode* parse_additive(Lexer* lexer) {
+    ASTNode* node = parse_term(lexer);
+    TokenType type = peek_token(lexer).type;
+    while (type == TOKEN_PLUS || type == TOKEN_MINUS) {
+        Token op = next_token(lexer);
+        node = create_binary_node(op, node, parse_term(lexer));
+        type = peek_token(lexer).type;
+    }
+    return node;
+}
+
+// espressione: somma (('<' | '>' | '==') somma)*
+ASTNode* parse_expression(Lexer* lexer) {
+    ASTNode* node = parse_additive(lexer);
+    TokenType type = peek_token(lexer).type;
+    while (type == TOKEN_LT || type == TOKEN_GT || type == TOKEN_EQ) {
+        Token op = next_token(lexer);
+        node = create_binary_node(op, node, parse_additive(lexer));
+        type = peek_token(lexer).type;
+    }
+    return node;
+}
+
+ASTNode* parse_statements(Lexer* lexer);
+
+// Condizione tra parentesi seguita da un blocco: usata da beta ed edging
+static void parse_condition_and_block(Lexer* lexer, ASTNode* node) {
+    expect_token(lexer, TOKEN_LPAREN, "'('");
+    node->left = parse_expression(lexer);
+    expect_token(lexer, TOKEN_RPAREN, "')'");
+    expect_token(lexer, TOKEN_LBRACE, "'{'");
+    node->right = parse_statements(lexer);
+}
 
+// beta (cond) { ... } [sigma { ... } | sigma beta ...]
+// beta è il token già letto: anche i beta di una catena "sigma beta" hanno la loro posizione
+static ASTNode* parse_if(Lexer* lexer, Token beta) {
+    ASTNode* node = create_node_from_token(NODE_IF_STATEMENT, beta);
+    parse_condition_and_block(lexer, node);
+
+    if (peek_token(lexer).type == TOKEN_SIGMA) {
+        next_token(lexer);
+        if (peek_token(lexer).type == TOKEN_BETA) {
+            node->alternate = parse_if(lexer, next_token(lexer));
+        } else {
+            expect_token(lexer, TOKEN_LBRACE, "'{'");
+            node->alternate = parse_statements(lexer);
+        }
+    }
     return node;
 }
 
@@ -262,37 +484,51 @@ ASTNode* parse_statements(Lexer* lexer) {
         ASTNode* statement = NULL;
 
         if (token.type == TOKEN_GYAT || token.type == TOKEN_RIZZ || token.type == TOKEN_YAP || token.type == TOKEN_CASEOH) {
-            // Dichiarazione e assegnazione
-            Token identifier = next_token(lexer);
-            if (identifier.type != TOKEN_IDENTIFIER) {
-                fprintf(stderr, "Errore di sintassi: identificatore atteso\n");
-                exit(1);
-            }
+            // Dichiarazione con inizializzazione opzionale
+            Token identifier = expect_token(lexer, TOKEN_IDENTIFIER, "identificatore");
+            statement = create_ast_node(NODE_DECLARATION, identifier.value);
 
             Token assign = next_token(lexer);
             if (assign.type == TOKEN_ASSIGN) {
-                Token value = next_token(lexer);
-                if (value.type != TOKEN_NUMBER) {
-                    fprintf(stderr, "Errore di sintassi: valore numerico atteso\n");
-                    exit(1);
-                }
-
-                Token semicolon = next_token(lexer);
-                if (semicolon.type != TOKEN_SEMICOLON) {
-                    fprintf(stderr, "Errore di sintassi: ';' atteso\n");
-                    exit(1);
-                }
-
-                statement = create_ast_node(NODE_ASSIGNMENT, identifier.value);
-                statement->left = create_ast_node(NODE_LITERAL, value.value);
+                statement->left = parse_expression(lexer);
+                expect_token(lexer, TOKEN_SEMICOLON, "';'");
+            } else if (assign.type != TOKEN_SEMICOLON) {
+                fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): ';' atteso, trovato '%s'\n",
+                        assign.line, assign.column, assign.value);
+                exit(1);
             }
-        } else if (token.type == TOKEN_YAPPER) {
-            statement = parse_function_call(lexer);
+        } else if (token.type == TOKEN_IDENTIFIER && peek_token(lexer).type == TOKEN_LPAREN) {
+            // Chiamata a funzione come statement: il risultato viene scartato
+            statement = parse_function_call(lexer, token);
+            expect_token(lexer, TOKEN_SEMICOLON, "';' dopo chiamata a funzione");
+        } else if (token.type == TOKEN_IDENTIFIER) {
+            // Assegnazione a una variabile già dichiarata
+            expect_token(lexer, TOKEN_ASSIGN, "'='");
+            statement = create_ast_node(NODE_ASSIGNMENT, token.value);
+            statement->left = parse_expression(lexer);
+            expect_token(lexer, TOKEN_SEMICOLON, "';'");
+        } else if (token.type == TOKEN_YAPPER || token.type == TOKEN_CASEOH_FUN) {
+            statement = parse_function_call(lexer, token);
+            expect_token(lexer, TOKEN_SEMICOLON, "';' dopo chiamata a funzione");
+        } else if (token.type == TOKEN_BETA) {
+            statement = parse_if(lexer, token);
+        } else if (token.type == TOKEN_NOMILK) {
+            statement = create_ast_node(NODE_RETURN, "nomilk");
+            if (peek_token(lexer).type != TOKEN_SEMICOLON) statement->left = parse_expression(lexer);
+            expect_token(lexer, TOKEN_SEMICOLON, "';'");
+        } else if (token.type == TOKEN_EDGING) {
+            statement = create_ast_node(NODE_WHILE_LOOP, "edging");
+            parse_condition_and_block(lexer, statement);
         } else {
-            fprintf(stderr, "Errore di sintassi: token non riconosciuto '%s'\n", token.value);
+            fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): token non riconosciuto '%s'\n",
+                    token.line, token.column, token.value);
             exit(1);
         }
 
+        // Ogni statement parte dal suo primo token
+        statement->line = token.line;
+        statement->column = token.column;
+
         if (!head) {
             head = statement;
         } else {
@@ -304,107 +540,1585 @@ ASTNode* parse_statements(Lexer* lexer) {
     return head;
 }
 
-// Parsing del programma principale
-ASTNode* parse_program(Lexer* lexer) {
+static int is_type_token(TokenType type) {
+    return type == TOKEN_GYAT || type == TOKEN_RIZZ || type == TOKEN_YAP || type == TOKEN_CASEOH;
+}
+
+static ASTNode* find_parameter(ASTNode* function, const char* name) {
+    for (ASTNode* parameter = function->left; parameter; parameter = parameter->next) {
+        if (strcmp(parameter->value, name) == 0) return parameter;
+    }
+    return NULL;
+}
+
+// Parametri e variabili locali condividono lo scope della funzione:
+// una dichiarazione con il nome di un parametro lo sovrascriverebbe
+static void check_parameter_shadowing(ASTNode* function, ASTNode* node) {
+    for (; node; node = node->next) {
+        if (node->type == NODE_DECLARATION && find_parameter(function, node->value)) {
+            fprintf(stderr, "Errore (riga %d, colonna %d): '%s' ridichiara un parametro di '%s'\n",
+                    node->line, node->column, node->value, function->value);
+            exit(1);
+        }
+        if (node->type == NODE_IF_STATEMENT || node->type == NODE_WHILE_LOOP) {
+            check_parameter_shadowing(function, node->right);
+            check_parameter_shadowing(function, node->alternate);
+        }
+    }
+}
+
+// tipo nome(tipo a, tipo b, ...) { ... }
+static ASTNode* parse_function(Lexer* lexer, Token type) {
+    if (!is_type_token(type.type) && type.type != TOKEN_TOILETSKIBIDI) {
+        fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): tipo di ritorno atteso, trovato '%s'\n",
+                type.line, type.column, type.value);
+        exit(1);
+    }
+
+    Token name = expect_token(lexer, TOKEN_IDENTIFIER, "nome della funzione");
+    ASTNode* function = create_node_from_token(NODE_FUNCTION, name);
+    function->line = type.line;
+    function->column = type.column;
+
+    expect_token(lexer, TOKEN_LPAREN, "'('");
+    ASTNode* last = NULL;
+    int parameter_count = 0;
     Token token = next_token(lexer);
-    if (token.type == TOKEN_TOILETSKIBIDI) {
+    while (token.type != TOKEN_RPAREN) {
+        if (!is_type_token(token.type)) {
+            fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): tipo del parametro atteso, trovato '%s'\n",
+                    token.line, token.column, token.value);
+            exit(1);
+        }
+        if (++parameter_count > MAX_CALL_ARGUMENTS) {
+            fprintf(stderr, "Errore (riga %d, colonna %d): la funzione '%s' ha più di %d parametri\n",
+                    token.line, token.column, function->value, MAX_CALL_ARGUMENTS);
+            exit(1);
+        }
+        ASTNode* parameter = create_node_from_token(NODE_IDENTIFIER, expect_token(lexer, TOKEN_IDENTIFIER, "nome del parametro"));
+        if (find_parameter(function, parameter->value)) {
+            fprintf(stderr, "Errore (riga %d, colonna %d): parametro '%s' ripetuto in '%s'\n",
+                    parameter->line, parameter->column, parameter->value, function->value);
+            exit(1);
+        }
+        if (last) {
+            last->next = parameter;
+        } else {
+            function->left = parameter;
+        }
+        last = parameter;
+
         token = next_token(lexer);
-        if (token.type == TOKEN_IDENTIFIER && strcmp(token.value, "main") == 0) {
+        if (token.type == TOKEN_COMMA) {
             token = next_token(lexer);
-            if (token.type == TOKEN_LPAREN) {
-                token = next_token(lexer);
-                if (token.type == TOKEN_RPAREN) {
-                    token = next_token(lexer);
-                    if (token.type == TOKEN_LBRACE) {
-                        ASTNode* program = create_ast_node(NODE_PROGRAM, "main");
-                        program->left = parse_statements(lexer);
-                        return program;
-                    }
-                }
+        } else if (token.type != TOKEN_RPAREN) {
+            fprintf(stderr, "Errore di sintassi (riga %d, colonna %d): ',' o ')' atteso, trovato '%s'\n",
+                    token.line, token.column, token.value);
+            exit(1);
+        }
+    }
+
+    expect_token(lexer, TOKEN_LBRACE, "'{'");
+    function->right = parse_statements(lexer);
+    check_parameter_shadowing(function, function->right);
+    return function;
+}
+
+// Parsing del programma: una lista di funzioni, tra cui main
+ASTNode* parse_program(Lexer* lexer) {
+    Token first = peek_token(lexer);
+    ASTNode* program = create_node_from_token(NODE_PROGRAM, first);
+    strcpy(program->value, "program");
+
+    ASTNode* last = NULL;
+    int has_main = 0;
+    while (peek_token(lexer).type != TOKEN_EOF) {
+        ASTNode* function = parse_function(lexer, next_token(lexer));
+        for (ASTNode* other = program->left; other; other = other->next) {
+            if (strcmp(other->value, function->value) == 0) {
+                fprintf(stderr, "Errore (riga %d, colonna %d): funzione '%s' definita due volte\n",
+                        function->line, function->column, function->value);
+                exit(1);
             }
         }
+        if (strcmp(function->value, "main") == 0) has_main = 1;
+
+        if (last) {
+            last->next = function;
+        } else {
+            program->left = function;
+        }
+        last = function;
+    }
+
+    if (!has_main) {
+        fprintf(stderr, "Errore di sintassi: programma non valido (manca main)\n");
+        exit(1);
     }
+    return program;
+}
+
+// ================================
+// STRUTTURA: Opzioni di compilazione
+// ================================
+typedef enum {
+    PROFILE_NONE,
+    PROFILE_GENERATE, // Strumenta i blocchi con contatori salvati all'uscita
+    PROFILE_USE       // Usa i contatori raccolti per disporre i blocchi
+} ProfileMode;
+
+typedef struct {
+    ProfileMode profile_mode;
+    const char* profile_path;
+    int debug_info;          // Emette direttive %line per .debug_line (nasm -g -F dwarf)
+    const char* source_path; // File .ohio citato nelle informazioni di debug
+} CompileOptions;
+
+// ================================
+// STRUTTURA: Contesto del Code Generator
+// ================================
+typedef struct {
+    char name[MAX_TOKEN_LENGTH];
+    int offset; // Offset rispetto a rbp, 0 se lo slot è libero
+} Symbol;
+
+typedef struct {
+    char* bytes;   // Già decodificati, possono contenere qualsiasi byte
+    size_t length;
+} Message;
 
-    fprintf(stderr, "Errore di sintassi: programma non valido\n");
+// Parametro di una funzione espansa inline, legato all'operando dell'argomento
+typedef struct {
+    const char* name;
+    char operand[MAX_TOKEN_LENGTH + 32];
+} InlineBinding;
+
+typedef struct {
+    FILE* output;
+    Message* messages; // Stringhe da emettere in .data
+    int message_count;
+    int message_capacity;
+    int io_runtime;    // Il programma usa yapper/caseoh_fun
+
+    Symbol* symbols;        // Variabili locali (tabella hash, capacità potenza di 2)
+    int symbol_count;
+    int symbol_capacity;
+    int label_count;
+
+    ProfileMode profile_mode;
+    const char* profile_path;
+    int profile_counter_count;
+    unsigned long long profile_checksum; // Forma dell'AST, per scartare profili vecchi
+    unsigned long long* profile_counts;  // Contatori letti con --profile-use
+    int in_cold_section;
+    int cold_section_declared;
+
+    const char* function_name;  // Funzione in generazione, per i simboli .end/.cold
+    int function_has_cold;
+    int debug_info;
+    const char* source_path;
+    int last_line;              // Ultima riga emessa con %line
+
+    ASTNode* functions;         // Funzioni definite nel programma
+    ASTNode* current_function;
+    int entry_label;            // Destinazione delle chiamate ricorsive in coda
+    InlineBinding* inline_bindings; // Non NULL mentre si espande una funzione inline
+    int inline_binding_count;
+} CodeGen;
+
+static void out_of_memory(void) {
+    fprintf(stderr, "Errore: memoria esaurita\n");
     exit(1);
 }
 
-// Generazione del codice per puntatori e array
-void generate_code(ASTNode* node, FILE* output, char messages[MAX_MESSAGE_COUNT][MAX_TOKEN_LENGTH], int* message_count) {
-    if (!node) return;
+// Registra una stringa nella tabella dei messaggi e ne restituisce l'indice
+static int add_message(CodeGen* gen, const char* bytes, size_t length) {
+    if (gen->message_count == gen->message_capacity) {
+        gen->message_capacity = gen->message_capacity ? gen->message_capacity * 2 : INITIAL_MESSAGE_CAPACITY;
+        gen->messages = realloc(gen->messages, gen->message_capacity * sizeof(*gen->messages));
+        if (!gen->messages) out_of_memory();
+    }
+    Message* message = &gen->messages[gen->message_count];
+    message->bytes = malloc(length);
+    if (!message->bytes) out_of_memory();
+    memcpy(message->bytes, bytes, length);
+    message->length = length;
+    return gen->message_count++;
+}
 
-    switch (node->type) {
-        case NODE_PROGRAM:
-            fprintf(output, "section .data\n");
-            for (int i = 0; i < *message_count; i++) {
-                fprintf(output, "    message%d db \"%s\", 0\n", i, messages[i]);
+// Stringa nasm tra backquote: i byte non stampabili diventano \xNN
+static void emit_message(FILE* output, int index, const Message* message) {
+    fprintf(output, "    message%d db `", index);
+    for (size_t i = 0; i < message->length; i++) {
+        unsigned char c = (unsigned char)message->bytes[i];
+        if (c >= 32 && c < 127 && c != '`' && c != '\\' && c != '"') {
+            fputc(c, output);
+        } else {
+            fprintf(output, "\\x%02x", c);
+        }
+    }
+    fprintf(output, "`\n");
+}
+
+// ================================
+// Variabili locali
+// ================================
+static unsigned long long fnv1a(const void* data, size_t length, unsigned long long hash) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static Symbol* find_symbol_slot(Symbol* symbols, int capacity, const char* name) {
+    unsigned long long mask = (unsigned long long)capacity - 1;
+    unsigned long long index = fnv1a(name, strlen(name), FNV_OFFSET_BASIS) & mask;
+    while (symbols[index].offset && strcmp(symbols[index].name, name) != 0) {
+        index = (index + 1) & mask;
+    }
+    return &symbols[index];
+}
+
+// Assegna uno slot nello stack frame alla variabile (una sola volta per nome)
+static void declare_symbol(CodeGen* gen, const char* name) {
+    if ((gen->symbol_count + 1) * 2 > gen->symbol_capacity) {
+        int capacity = gen->symbol_capacity ? gen->symbol_capacity * 2 : INITIAL_SYMBOL_CAPACITY;
+        Symbol* symbols = calloc(capacity, sizeof(Symbol));
+        if (!symbols) out_of_memory();
+        for (int i = 0; i < gen->symbol_capacity; i++) {
+            if (gen->symbols[i].offset) {
+                *find_symbol_slot(symbols, capacity, gen->symbols[i].name) = gen->symbols[i];
             }
-            fprintf(output, "\nsection .text\n");
-            fprintf(output, "global _start\n");
-            fprintf(output, "_start:\n");
-            generate_code(node->left, output, messages, message_count);
-            fprintf(output, "    mov rax, 60 ; sys_exit\n");
-            fprintf(output, "    xor rdi, rdi ; exit code 0\n");
-            fprintf(output, "    syscall\n");
-            break;
+        }
+        free(gen->symbols);
+        gen->symbols = symbols;
+        gen->symbol_capacity = capacity;
+    }
 
-        case NODE_FUNCTION_CALL:
-            if (strcmp(node->value, "yapper") == 0) {
-                int message_index = *message_count;
-                strncpy(messages[message_index], node->left->value, MAX_TOKEN_LENGTH);
-                (*message_count)++;
-                fprintf(output, "    mov rax, 1 ; syscall write\n");
-                fprintf(output, "    mov rdi, 1 ; stdout\n");
-                fprintf(output, "    mov rsi, message%d\n", message_index);
-                fprintf(output, "    mov rdx, %lu\n", strlen(messages[message_index - 1]));
-                fprintf(output, "    syscall\n");
+    Symbol* slot = find_symbol_slot(gen->symbols, gen->symbol_capacity, name);
+    if (!slot->offset) {
+        strcpy(slot->name, name);
+        slot->offset = ++gen->symbol_count * 8;
+    }
+}
+
+static int lookup_symbol(CodeGen* gen, const char* name) {
+    Symbol* slot = gen->symbol_capacity ? find_symbol_slot(gen->symbols, gen->symbol_capacity, name) : NULL;
+    if (!slot || !slot->offset) {
+        fprintf(stderr, "Errore: variabile '%s' non dichiarata\n", name);
+        exit(1);
+    }
+    return slot->offset;
+}
+
+static void reset_symbols(CodeGen* gen) {
+    free(gen->symbols);
+    gen->symbols = NULL;
+    gen->symbol_count = 0;
+    gen->symbol_capacity = 0;
+}
+
+// Raccoglie le dichiarazioni del corpo: ogni funzione ha un unico scope piatto
+static void collect_locals(ASTNode* node, CodeGen* gen) {
+    for (; node; node = node->next) {
+        if (node->type == NODE_DECLARATION) {
+            declare_symbol(gen, node->value);
+        } else if (node->type == NODE_IF_STATEMENT || node->type == NODE_WHILE_LOOP) {
+            collect_locals(node->right, gen);
+            collect_locals(node->alternate, gen);
+        }
+    }
+}
+
+static int is_user_call(ASTNode* node) {
+    return node->type == NODE_FUNCTION_CALL &&
+           strcmp(node->value, "yapper") != 0 && strcmp(node->value, "caseoh_fun") != 0;
+}
+
+// Slot temporanei per gli argomenti complessi delle funzioni espanse inline
+static const char* inline_temp_name(int index) {
+    static const char* names[MAX_CALL_ARGUMENTS] = {"inline#0", "inline#1", "inline#2", "inline#3", "inline#4", "inline#5"};
+    return names[index];
+}
+
+// ================================
+// Profile-guided optimization
+// ================================
+// Ogni beta ed edging ha due contatori: esecuzioni del costrutto e del blocco
+// principale (ramo beta o corpo del ciclo). Gli altri blocchi si ricavano per
+// differenza: sigma = totale - beta, uscita dal ciclo = totale. Ogni funzione
+// ha un contatore delle chiamate, usato per decidere l'espansione inline.
+static void assign_profile_ids(ASTNode* node, CodeGen* gen) {
+    for (; node; node = node->next) {
+        if (node->type == NODE_PROGRAM) {
+            assign_profile_ids(node->left, gen);
+        } else if (node->type == NODE_FUNCTION) {
+            node->profile_id = gen->profile_counter_count++;
+            gen->profile_checksum = fnv1a(node->value, strlen(node->value), gen->profile_checksum);
+            assign_profile_ids(node->right, gen);
+        } else if (node->type == NODE_IF_STATEMENT || node->type == NODE_WHILE_LOOP) {
+            node->profile_id = gen->profile_counter_count;
+            gen->profile_counter_count += 2;
+
+            int shape[2] = {node->type, node->alternate != NULL};
+            gen->profile_checksum = fnv1a(shape, sizeof(shape), gen->profile_checksum);
+            assign_profile_ids(node->right, gen);
+            assign_profile_ids(node->alternate, gen);
+        }
+    }
+}
+
+static void load_profile(CodeGen* gen) {
+    FILE* file = fopen(gen->profile_path, "rb");
+    if (!file) {
+        perror("Errore nell'apertura del profilo");
+        exit(1);
+    }
+
+    char magic[8];
+    unsigned long long header[2]; // Numero di contatori, checksum
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, PROFILE_MAGIC, sizeof(magic)) != 0 ||
+        fread(header, sizeof(header[0]), 2, file) != 2) {
+        fprintf(stderr, "Errore: '%s' non è un profilo valido\n", gen->profile_path);
+        exit(1);
+    }
+
+    if (header[0] != (unsigned long long)gen->profile_counter_count || header[1] != gen->profile_checksum) {
+        fprintf(stderr, "Avviso: il profilo '%s' non corrisponde al programma, ignorato\n", gen->profile_path);
+        fclose(file);
+        return;
+    }
+
+    gen->profile_counts = calloc(gen->profile_counter_count + 1, sizeof(unsigned long long));
+    if (!gen->profile_counts) out_of_memory();
+    if (fread(gen->profile_counts, sizeof(unsigned long long), gen->profile_counter_count, file) != header[0]) {
+        fprintf(stderr, "Errore: profilo '%s' troncato\n", gen->profile_path);
+        exit(1);
+    }
+    fclose(file);
+}
+
+static void emit_profile_counter(CodeGen* gen, int counter) {
+    fprintf(gen->output, "    inc qword [__ohio_profile + %d]\n", counter * 8);
+}
+
+// Contatori raccolti per un costrutto; 0 se non c'è un profilo utile
+static int profile_counts(CodeGen* gen, ASTNode* node, unsigned long long* total, unsigned long long* primary) {
+    if (!gen->profile_counts || node->profile_id < 0) return 0;
+    *total = gen->profile_counts[node->profile_id];
+    *primary = gen->profile_counts[node->profile_id + 1];
+    return *total > 0;
+}
+
+static int is_cold(unsigned long long count, unsigned long long other) {
+    return count * PROFILE_COLD_RATIO < other;
+}
+
+static int count_statements(ASTNode* node) {
+    int count = 0;
+    for (; node; node = node->next) {
+        count += 1 + count_statements(node->right) + count_statements(node->alternate);
+    }
+    return count;
+}
+
+// Scrive header e contatori nel file del profilo prima di sys_exit
+static void emit_profile_dump(CodeGen* gen) {
+    FILE* output = gen->output;
+    int done = gen->label_count++;
+    fprintf(output, "    ; Salva i contatori del profilo in %s\n", gen->profile_path);
+    fprintf(output, "    mov rax, 2 ; sys_open\n");
+    fprintf(output, "    mov rdi, __ohio_profile_path\n");
+    fprintf(output, "    mov rsi, 577 ; O_WRONLY | O_CREAT | O_TRUNC\n");
+    fprintf(output, "    mov rdx, 420 ; 0644\n");
+    fprintf(output, "    syscall\n");
+    fprintf(output, "    test rax, rax\n");
+    fprintf(output, "    js .L%d\n", done);
+    fprintf(output, "    mov rdi, rax\n");
+    fprintf(output, "    mov rax, 1 ; sys_write\n");
+    fprintf(output, "    mov rsi, __ohio_profile_header\n");
+    fprintf(output, "    mov rdx, %d\n", PROFILE_HEADER_SIZE + gen->profile_counter_count * 8);
+    fprintf(output, "    syscall\n");
+    fprintf(output, "    mov rax, 3 ; sys_close\n");
+    fprintf(output, "    syscall\n");
+    fprintf(output, ".L%d:\n", done);
+}
+
+static void emit_profile_data(CodeGen* gen) {
+    FILE* output = gen->output;
+    fprintf(output, "    __ohio_profile_path db ");
+    for (const char* c = gen->profile_path; *c; c++) {
+        fprintf(output, "%d, ", (unsigned char)*c);
+    }
+    fprintf(output, "0\n");
+    fprintf(output, "    align 8\n");
+    fprintf(output, "    __ohio_profile_header db \"%s\"\n", PROFILE_MAGIC);
+    fprintf(output, "    dq %d\n", gen->profile_counter_count);
+    fprintf(output, "    dq 0x%016llx\n", gen->profile_checksum);
+    fprintf(output, "    __ohio_profile times %d dq 0\n", gen->profile_counter_count);
+}
+
+// I blocchi freddi finiscono in .text.unlikely, fuori dal percorso caldo.
+// La parte fredda di ogni funzione ha il proprio simbolo <funzione>.cold
+static void begin_cold(CodeGen* gen) {
+    FILE* output = gen->output;
+    if (!gen->cold_section_declared) {
+        fprintf(output, "section .text.unlikely progbits alloc exec nowrite align=16\n");
+        gen->cold_section_declared = 1;
+    } else {
+        fprintf(output, "section .text.unlikely\n");
+    }
+    if (!gen->function_has_cold) {
+        fprintf(output, "global %s.cold:function (%s.cold_end - %s.cold)\n",
+                gen->function_name, gen->function_name, gen->function_name);
+        fprintf(output, ".cold:\n");
+        gen->function_has_cold = 1;
+    }
+    gen->in_cold_section = 1;
+}
+
+static void end_cold(CodeGen* gen) {
+    fprintf(gen->output, "section .text\n");
+    gen->in_cold_section = 0;
+}
+
+// ================================
+// Simboli e informazioni di debug
+// ================================
+// Ogni funzione è un simbolo ELF di tipo function con dimensione, così
+// perf e objdump attribuiscono i campioni alla funzione giusta
+static void begin_function(CodeGen* gen, const char* name) {
+    fprintf(gen->output, "global %s:function (%s.end - %s)\n", name, name, name);
+    fprintf(gen->output, "%s:\n", name);
+    gen->function_name = name;
+    gen->function_has_cold = 0;
+}
+
+static void end_function(CodeGen* gen) {
+    fprintf(gen->output, ".end:\n");
+    if (gen->function_has_cold) {
+        fprintf(gen->output, "section .text.unlikely\n");
+        fprintf(gen->output, ".cold_end:\n");
+        fprintf(gen->output, "section .text\n");
+    }
+}
+
+// Associa il codice che segue alla riga .ohio del nodo (nasm non registra le colonne)
+static void emit_source_line(CodeGen* gen, ASTNode* node) {
+    if (!gen->debug_info || node->line <= 0 || node->line == gen->last_line) return;
+    fprintf(gen->output, "    ; %s:%d:%d\n", gen->source_path, node->line, node->column);
+    fprintf(gen->output, "%%line %d+0 %s\n", node->line, gen->source_path);
+    gen->last_line = node->line;
+}
+
+// ================================
+// Runtime I/O
+// ================================
+// Runtime freestanding emesso nel .asm quando servono yapper o caseoh_fun:
+// stdout e stdin passano da buffer da 64 KiB, quindi una syscall serve solo
+// quando un buffer è pieno/vuoto e all'uscita. yapper viene specializzato a
+// tempo di compilazione in chiamate dirette a questi entry point.
+static int needs_io_runtime(ASTNode* node) {
+    for (; node; node = node->next) {
+        if (node->type == NODE_FUNCTION_CALL &&
+            (strcmp(node->value, "yapper") == 0 || strcmp(node->value, "caseoh_fun") == 0)) return 1;
+        if (node->type == NODE_PROGRAM && needs_io_runtime(node->left)) return 1;
+        if (node->type == NODE_FUNCTION && needs_io_runtime(node->right)) return 1;
+        if (node->type == NODE_IF_STATEMENT || node->type == NODE_WHILE_LOOP) {
+            if (needs_io_runtime(node->right) || needs_io_runtime(node->alternate)) return 1;
+        }
+    }
+    return 0;
+}
+
+static void emit_runtime(CodeGen* gen) {
+    FILE* output = gen->output;
+    fprintf(output, "__ohio_OUTBUF_SIZE equ %d\n", IO_BUFFER_SIZE);
+    fprintf(output, "__ohio_INBUF_SIZE equ %d\n\n", IO_BUFFER_SIZE);
+
+    // Svuota il buffer di stdout
+    begin_function(gen, "__ohio_flush");
+    fputs("    mov rdx, [__ohio_outpos]\n"
+          "    mov rsi, __ohio_outbuf\n"
+          "    mov rdi, 1 ; stdout\n"
+          ".again:\n"
+          "    test rdx, rdx\n"
+          "    jz .done\n"
+          "    mov rax, 1 ; sys_write\n"
+          "    syscall\n"
+          "    test rax, rax\n"
+          "    jle .done ; errore di scrittura: l'output viene scartato\n"
+          "    add rsi, rax\n"
+          "    sub rdx, rax\n"
+          "    jmp .again\n"
+          ".done:\n"
+          "    mov qword [__ohio_outpos], 0\n"
+          "    ret\n", output);
+    end_function(gen);
+
+    // rsi = byte, rdx = lunghezza; blocchi più grandi del buffer vanno diretti
+    begin_function(gen, "__ohio_write_bytes");
+    fputs("    mov rax, [__ohio_outpos]\n"
+          "    lea rcx, [rax + rdx]\n"
+          "    cmp rcx, __ohio_OUTBUF_SIZE\n"
+          "    jbe .copy\n"
+          "    push rsi\n"
+          "    push rdx\n"
+          "    call __ohio_flush\n"
+          "    pop rdx\n"
+          "    pop rsi\n"
+          "    xor eax, eax\n"
+          "    cmp rdx, __ohio_OUTBUF_SIZE\n"
+          "    jbe .copy\n"
+          "    mov rdi, 1 ; stdout\n"
+          ".direct:\n"
+          "    mov rax, 1 ; sys_write\n"
+          "    syscall\n"
+          "    test rax, rax\n"
+          "    jle .done\n"
+          "    add rsi, rax\n"
+          "    sub rdx, rax\n"
+          "    jnz .direct\n"
+          ".done:\n"
+          "    ret\n"
+          ".copy:\n"
+          "    lea rdi, [rax + __ohio_outbuf]\n"
+          "    mov rcx, rdx\n"
+          "    rep movsb\n"
+          "    add rax, rdx\n"
+          "    mov [__ohio_outpos], rax\n"
+          "    ret\n", output);
+    end_function(gen);
+
+    // rdi = carattere
+    begin_function(gen, "__ohio_write_char");
+    fputs("    mov rax, [__ohio_outpos]\n"
+          "    cmp rax, __ohio_OUTBUF_SIZE\n"
+          "    jb .room\n"
+          "    push rdi\n"
+          "    call __ohio_flush\n"
+          "    pop rdi\n"
+          "    xor eax, eax\n"
+          ".room:\n"
+          "    mov [rax + __ohio_outbuf], dil\n"
+          "    inc rax\n"
+          "    mov [__ohio_outpos], rax\n"
+          "    ret\n", output);
+    end_function(gen);
+
+    // rdi = intero con segno. Due cifre per passo dalla tabella
+    // __ohio_digit_pairs, divisione per 100 con moltiplicazione per il reciproco
+    begin_function(gen, "__ohio_write_int");
+    fputs("    mov rax, [__ohio_outpos]\n"
+          "    cmp rax, __ohio_OUTBUF_SIZE - 20\n"
+          "    jbe .room\n"
+          "    push rdi\n"
+          "    call __ohio_flush\n"
+          "    pop rdi\n"
+          "    xor eax, eax\n"
+          ".room:\n"
+          "    lea r8, [rax + __ohio_outbuf]\n"
+          "    mov rax, rdi\n"
+          "    test rax, rax\n"
+          "    jns .digits\n"
+          "    mov byte [r8], '-'\n"
+          "    inc r8\n"
+          "    neg rax ; da qui il valore è trattato come senza segno\n"
+          ".digits:\n"
+          "    lea r9, [rsp - 8] ; le cifre vengono scritte a ritroso nella red zone\n"
+          "    mov r10, r9\n"
+          "    mov r11, 0x28f5c28f5c28f5c3\n"
+          ".pairs:\n"
+          "    cmp rax, 100\n"
+          "    jb .last\n"
+          "    mov rcx, rax\n"
+          "    shr rax, 2\n"
+          "    mul r11\n"
+          "    shr rdx, 2 ; rdx = valore / 100\n"
+          "    imul rax, rdx, 100\n"
+          "    sub rcx, rax ; rcx = valore % 100\n"
+          "    mov rax, rdx\n"
+          "    movzx ecx, word [rcx*2 + __ohio_digit_pairs]\n"
+          "    sub r9, 2\n"
+          "    mov [r9], cx\n"
+          "    jmp .pairs\n"
+          ".last:\n"
+          "    cmp rax, 10\n"
+          "    jb .single\n"
+          "    movzx ecx, word [rax*2 + __ohio_digit_pairs]\n"
+          "    sub r9, 2\n"
+          "    mov [r9], cx\n"
+          "    jmp .copy\n"
+          ".single:\n"
+          "    add eax, '0'\n"
+          "    dec r9\n"
+          "    mov [r9], al\n"
+          ".copy:\n"
+          "    mov rsi, r9\n"
+          "    mov rdi, r8\n"
+          "    mov rcx, r10\n"
+          "    sub rcx, r9\n"
+          "    rep movsb\n"
+          "    sub rdi, __ohio_outbuf\n"
+          "    mov [__ohio_outpos], rdi\n"
+          "    ret\n", output);
+    end_function(gen);
+
+    // Ricarica il buffer di stdin; rax = byte letti, 0 a fine input.
+    // Dopo i dati c'è sempre un byte 0 che ferma il parser degli interi
+    begin_function(gen, "__ohio_fill");
+    fputs("    call __ohio_flush ; l'output in sospeso (es. un prompt) precede la lettura\n"
+          "    xor eax, eax ; sys_read\n"
+          "    xor edi, edi ; stdin\n"
+          "    mov rsi, __ohio_inbuf\n"
+          "    mov rdx, __ohio_INBUF_SIZE\n"
+          "    syscall\n"
+          "    test rax, rax\n"
+          "    jg .ok\n"
+          "    xor eax, eax\n"
+          ".ok:\n"
+          "    mov [__ohio_inlen], rax\n"
+          "    mov qword [__ohio_inpos], 0\n"
+          "    mov byte [rax + __ohio_inbuf], 0\n"
+          "    ret\n", output);
+    end_function(gen);
+
+    // rax = prossimo byte di stdin, -1 a fine input
+    begin_function(gen, "__ohio_read_char");
+    fputs("    mov rax, [__ohio_inpos]\n"
+          "    cmp rax, [__ohio_inlen]\n"
+          "    jb .have\n"
+          "    call __ohio_fill\n"
+          "    test rax, rax\n"
+          "    jz .eof\n"
+          "    xor eax, eax\n"
+          ".have:\n"
+          "    movzx ecx, byte [rax + __ohio_inbuf]\n"
+          "    inc rax\n"
+          "    mov [__ohio_inpos], rax\n"
+          "    mov eax, ecx\n"
+          "    ret\n"
+          ".eof:\n"
+          "    mov rax, -1\n"
+          "    ret\n", output);
+    end_function(gen);
+
+    // rax = intero decimale con segno letto da stdin (0 se assente). Il ciclo
+    // sulle cifre ha un solo salto: la sentinella evita i controlli sui limiti
+    begin_function(gen, "__ohio_read_int");
+    fputs("    push rbx\n"
+          "    push r12\n"
+          "    xor ebx, ebx\n"
+          "    xor r12d, r12d ; 1 se negativo\n"
+          ".skip:\n"
+          "    call __ohio_read_char\n"
+          "    cmp rax, -1\n"
+          "    je .finish\n"
+          "    lea ecx, [rax - 9]\n"
+          "    cmp ecx, 4 ; da \\t a \\r\n"
+          "    jbe .skip\n"
+          "    cmp eax, ' '\n"
+          "    je .skip\n"
+          "    cmp eax, '-'\n"
+          "    jne .first\n"
+          "    mov r12d, 1\n"
+          "    call __ohio_read_char\n"
+          "    cmp rax, -1\n"
+          "    je .finish\n"
+          ".first:\n"
+          "    sub eax, '0'\n"
+          "    cmp eax, 9\n"
+          "    ja .not_number\n"
+          "    mov ebx, eax\n"
+          ".digits:\n"
+          "    mov rsi, [__ohio_inpos]\n"
+          ".loop:\n"
+          "    movzx eax, byte [rsi + __ohio_inbuf]\n"
+          "    sub eax, '0'\n"
+          "    cmp eax, 9\n"
+          "    ja .stop\n"
+          "    lea rbx, [rbx + rbx*4]\n"
+          "    lea rbx, [rax + rbx*2] ; rbx = rbx * 10 + cifra\n"
+          "    inc rsi\n"
+          "    jmp .loop\n"
+          ".stop:\n"
+          "    mov [__ohio_inpos], rsi\n"
+          "    cmp rsi, [__ohio_inlen]\n"
+          "    jb .finish\n"
+          "    call __ohio_fill ; era la sentinella: il numero può continuare\n"
+          "    test rax, rax\n"
+          "    jnz .digits\n"
+          "    jmp .finish\n"
+          ".not_number:\n"
+          "    dec qword [__ohio_inpos] ; il carattere resta da leggere\n"
+          ".finish:\n"
+          "    mov rax, rbx\n"
+          "    neg r12\n"
+          "    xor rax, r12\n"
+          "    sub rax, r12 ; negazione senza salti\n"
+          "    pop r12\n"
+          "    pop rbx\n"
+          "    ret\n", output);
+    end_function(gen);
+    fprintf(output, "\n");
+}
+
+static void emit_runtime_data(FILE* output) {
+    fprintf(output, "    __ohio_digit_pairs db \"");
+    for (int i = 0; i < 100; i++) {
+        fprintf(output, "%02d", i);
+    }
+    fprintf(output, "\"\n");
+    fprintf(output, "\nsection .bss\n");
+    fprintf(output, "    __ohio_outbuf resb __ohio_OUTBUF_SIZE\n");
+    fprintf(output, "    __ohio_inbuf resb __ohio_INBUF_SIZE + 1\n");
+    fprintf(output, "    alignb 8\n");
+    fprintf(output, "    __ohio_outpos resq 1\n");
+    fprintf(output, "    __ohio_inpos resq 1\n");
+    fprintf(output, "    __ohio_inlen resq 1\n");
+}
+
+// ================================
+// Funzioni Code Generator
+// ================================
+void generate_code(ASTNode* node, CodeGen* gen);
+void generate_expression(ASTNode* node, CodeGen* gen);
+void generate_call(ASTNode* call, CodeGen* gen);
+
+static int new_label(CodeGen* gen) {
+    return gen->label_count++;
+}
+
+static int is_comparison(ASTNode* node) {
+    return node->type == NODE_BINARY_OP &&
+           (node->value[0] == '<' || node->value[0] == '>' || node->value[0] == '=');
+}
+
+// Operando di una variabile: il suo slot o, dentro un'espansione inline,
+// l'operando dell'argomento legato al parametro
+static void variable_operand(CodeGen* gen, const char* name, char* operand, size_t size) {
+    if (gen->inline_bindings) {
+        for (int i = 0; i < gen->inline_binding_count; i++) {
+            if (strcmp(gen->inline_bindings[i].name, name) == 0) {
+                snprintf(operand, size, "%s", gen->inline_bindings[i].operand);
+                return;
             }
+        }
+        fprintf(stderr, "Errore: variabile '%s' non dichiarata\n", name);
+        exit(1);
+    }
+    snprintf(operand, size, "qword [rbp-%d]", lookup_symbol(gen, name));
+}
+
+static int is_simple_operand(ASTNode* node) {
+    if (node->type == NODE_LITERAL) return strtoll(node->value, NULL, 10) <= 2147483647LL;
+    return node->type == NODE_IDENTIFIER;
+}
+
+// Operando usabile direttamente da un'istruzione: immediato a 32 bit o variabile
+static int simple_operand(ASTNode* node, CodeGen* gen, char* operand, size_t size) {
+    if (!is_simple_operand(node)) return 0;
+    if (node->type == NODE_LITERAL) {
+        snprintf(operand, size, "%lld", strtoll(node->value, NULL, 10));
+    } else {
+        variable_operand(gen, node->value, operand, size);
+    }
+    return 1;
+}
+
+// Valuta il lato sinistro in rax e prepara il destro come operando (eventualmente in rcx)
+static void generate_operands(ASTNode* node, CodeGen* gen, char* operand, size_t size) {
+    FILE* output = gen->output;
+    generate_expression(node->left, gen);
+    if (!simple_operand(node->right, gen, operand, size)) {
+        fprintf(output, "    push rax\n");
+        generate_expression(node->right, gen);
+        fprintf(output, "    mov rcx, rax\n");
+        fprintf(output, "    pop rax\n");
+        snprintf(operand, size, "rcx");
+    }
+}
+
+static const char* condition_jump(char op, int jump_if_true) {
+    switch (op) {
+        case '<': return jump_if_true ? "jl" : "jge";
+        case '>': return jump_if_true ? "jg" : "jle";
+        default:  return jump_if_true ? "je" : "jne"; // ==
+    }
+}
+
+// Valuta un'espressione lasciando il risultato in rax
+void generate_expression(ASTNode* node, CodeGen* gen) {
+    FILE* output = gen->output;
+    char operand[MAX_TOKEN_LENGTH + 32];
+
+    switch (node->type) {
+        case NODE_LITERAL:
+            fprintf(output, "    mov rax, %s\n", node->value);
+            return;
+
+        case NODE_IDENTIFIER:
+            variable_operand(gen, node->value, operand, sizeof(operand));
+            fprintf(output, "    mov rax, %s ; %s\n", operand, node->value);
+            return;
+
+        case NODE_FUNCTION_CALL:
+            generate_call(node, gen);
+            return;
+
+        case NODE_BINARY_OP:
             break;
 
         default:
-            fprintf(stderr, "Errore: Nodo non supportato\n");
+            fprintf(stderr, "Errore: espressione non supportata\n");
+            exit(1);
+    }
+
+    generate_operands(node, gen, operand, sizeof(operand));
+    switch (node->value[0]) {
+        case '+':
+            fprintf(output, "    add rax, %s\n", operand);
+            break;
+        case '-':
+            fprintf(output, "    sub rax, %s\n", operand);
+            break;
+        case '*':
+            if (node->right->type == NODE_LITERAL && strcmp(operand, "rcx") != 0) {
+                fprintf(output, "    imul rax, rax, %s\n", operand);
+            } else {
+                fprintf(output, "    imul rax, %s\n", operand);
+            }
+            break;
+        case '/':
+            if (strcmp(operand, "rcx") != 0) fprintf(output, "    mov rcx, %s\n", operand);
+            fprintf(output, "    cqo\n");
+            fprintf(output, "    idiv rcx\n");
+            break;
+        default: // Confronti: 1 se vero, 0 altrimenti
+            fprintf(output, "    cmp rax, %s\n", operand);
+            fprintf(output, "    %s al\n", node->value[0] == '<' ? "setl" : node->value[0] == '>' ? "setg" : "sete");
+            fprintf(output, "    movzx eax, al\n");
+            break;
+    }
+}
+
+// Salta a label se la condizione è uguale a jump_if_true
+static void generate_branch(ASTNode* condition, CodeGen* gen, int jump_if_true, int label) {
+    FILE* output = gen->output;
+    emit_source_line(gen, condition);
+    if (is_comparison(condition)) {
+        char operand[MAX_TOKEN_LENGTH + 32];
+        generate_operands(condition, gen, operand, sizeof(operand));
+        fprintf(output, "    cmp rax, %s\n", operand);
+        fprintf(output, "    %s .L%d\n", condition_jump(condition->value[0], jump_if_true), label);
+    } else {
+        generate_expression(condition, gen);
+        fprintf(output, "    test rax, rax\n");
+        fprintf(output, "    %s .L%d\n", jump_if_true ? "jnz" : "jz", label);
+    }
+}
+
+// ================================
+// Chiamate a funzione
+// ================================
+// Convenzione di chiamata in stile System V: argomenti in registri, risultato
+// in rax, nessun argomento sullo stack.
+static const char* argument_registers[MAX_CALL_ARGUMENTS] = {"rdi", "rsi", "rdx", "rcx", "r8", "r9"};
+
+static ASTNode* find_function(CodeGen* gen, const char* name) {
+    for (ASTNode* function = gen->functions; function; function = function->next) {
+        if (strcmp(function->value, name) == 0) return function;
+    }
+    fprintf(stderr, "Errore: funzione '%s' non definita\n", name);
+    exit(1);
+}
+
+static int collect_arguments(ASTNode* call, ASTNode* function, ASTNode** arguments) {
+    int count = 0, expected = 0;
+    for (ASTNode* argument = call->left; argument; argument = argument->next) {
+        if (count == MAX_CALL_ARGUMENTS) {
+            fprintf(stderr, "Errore: troppi argomenti nella chiamata a '%s' (massimo %d)\n", function->value, MAX_CALL_ARGUMENTS);
             exit(1);
+        }
+        arguments[count++] = argument;
+    }
+    for (ASTNode* parameter = function->left; parameter; parameter = parameter->next) expected++;
+    if (count != expected) {
+        fprintf(stderr, "Errore: la funzione '%s' richiede %d argomenti, %d forniti\n", function->value, expected, count);
+        exit(1);
+    }
+    return count;
+}
+
+// Carica gli argomenti nei registri: quelli complessi vengono valutati in
+// ordine e parcheggiati sullo stack, quelli semplici caricati per ultimi
+static int load_call_arguments(ASTNode* call, ASTNode* function, CodeGen* gen) {
+    FILE* output = gen->output;
+    ASTNode* arguments[MAX_CALL_ARGUMENTS];
+    int simple[MAX_CALL_ARGUMENTS];
+    char operand[MAX_TOKEN_LENGTH + 32];
+    int count = collect_arguments(call, function, arguments);
+
+    for (int i = 0; i < count; i++) {
+        simple[i] = simple_operand(arguments[i], gen, operand, sizeof(operand));
+        if (!simple[i]) {
+            generate_expression(arguments[i], gen);
+            fprintf(output, "    push rax\n");
+        }
     }
+    for (int i = count - 1; i >= 0; i--) {
+        if (!simple[i]) fprintf(output, "    pop %s\n", argument_registers[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        if (simple[i]) {
+            simple_operand(arguments[i], gen, operand, sizeof(operand));
+            fprintf(output, "    mov %s, %s\n", argument_registers[i], operand);
+        }
+    }
+    return count;
+}
+
+// Corpo espandibile inline: una funzione foglia fatta solo di "nomilk espressione;"
+static ASTNode* inline_body(ASTNode* function) {
+    ASTNode* body = function->right;
+    if (!body || body->next || body->type != NODE_RETURN || !body->left) return NULL;
+    return body->left;
+}
+
+// Nodi dell'espressione, -1 se contiene chiamate o stringhe
+static int expression_size(ASTNode* node) {
+    if (!node) return 0;
+    if (node->type == NODE_FUNCTION_CALL || node->type == NODE_STRING) return -1;
+    int left = expression_size(node->left);
+    int right = expression_size(node->right);
+    if (left < 0 || right < 0) return -1;
+    return 1 + left + right;
+}
 
-    generate_code(node->next, output, messages, message_count);
+static int should_inline(CodeGen* gen, ASTNode* function) {
+    ASTNode* expression = inline_body(function);
+    int size = expression ? expression_size(expression) : -1;
+    if (size < 0) return 0;
+
+    if (gen->profile_counts) {
+        unsigned long long calls = gen->profile_counts[function->profile_id];
+        if (calls == 0) return 0; // Mai chiamata: meglio una call compatta
+        if (calls >= INLINE_HOT_MIN_CALLS) return size <= INLINE_HOT_MAX_NODES;
+    }
+    return size <= INLINE_MAX_NODES;
+}
+
+// Espansione inline: i parametri diventano gli operandi degli argomenti
+// (variabili e immediati direttamente, il resto tramite slot temporanei)
+static void generate_inline_call(ASTNode* call, ASTNode* function, CodeGen* gen) {
+    FILE* output = gen->output;
+    ASTNode* arguments[MAX_CALL_ARGUMENTS];
+    InlineBinding bindings[MAX_CALL_ARGUMENTS];
+    int simple[MAX_CALL_ARGUMENTS];
+    int count = collect_arguments(call, function, arguments);
+    int temps = 0;
+
+    ASTNode* parameter = function->left;
+    for (int i = 0; i < count; i++, parameter = parameter->next) {
+        bindings[i].name = parameter->value;
+        simple[i] = simple_operand(arguments[i], gen, bindings[i].operand, sizeof(bindings[i].operand));
+        if (!simple[i]) {
+            generate_expression(arguments[i], gen);
+            fprintf(output, "    push rax\n");
+            snprintf(bindings[i].operand, sizeof(bindings[i].operand), "qword [rbp-%d]",
+                     lookup_symbol(gen, inline_temp_name(temps++)));
+        }
+    }
+    for (int i = count - 1; i >= 0; i--) {
+        if (!simple[i]) {
+            fprintf(output, "    pop rax\n");
+            fprintf(output, "    mov %s, rax\n", bindings[i].operand);
+        }
+    }
+
+    fprintf(output, "    ; inline %s\n", function->value);
+    if (gen->profile_mode == PROFILE_GENERATE) emit_profile_counter(gen, function->profile_id);
+    gen->inline_bindings = bindings;
+    gen->inline_binding_count = count;
+    generate_expression(inline_body(function), gen);
+    gen->inline_bindings = NULL;
+    gen->inline_binding_count = 0;
+}
+
+// Slot temporanei richiesti dalle chiamate espanse inline nel corpo: uno per
+// argomento complesso, riusati da una chiamata all'altra
+static int inline_temps_needed(ASTNode* node, CodeGen* gen) {
+    int needed = 0;
+    for (; node; node = node->next) {
+        if (is_user_call(node) && should_inline(gen, find_function(gen, node->value))) {
+            int temps = 0;
+            for (ASTNode* argument = node->left; argument; argument = argument->next) {
+                // Gli argomenti in eccesso vengono segnalati da collect_arguments
+                if (!is_simple_operand(argument) && temps < MAX_CALL_ARGUMENTS) temps++;
+            }
+            if (temps > needed) needed = temps;
+        }
+        int left = inline_temps_needed(node->left, gen);
+        int right = inline_temps_needed(node->right, gen);
+        int alternate = inline_temps_needed(node->alternate, gen);
+        if (left > needed) needed = left;
+        if (right > needed) needed = right;
+        if (alternate > needed) needed = alternate;
+    }
+    return needed;
 }
 
-void generate_program(ASTNode* ast, const char* output_file) {
+// Chiamata a una funzione definita dall'utente, risultato in rax
+void generate_call(ASTNode* call, CodeGen* gen) {
+    ASTNode* function = find_function(gen, call->value);
+    if (should_inline(gen, function)) {
+        generate_inline_call(call, function, gen);
+        return;
+    }
+    load_call_arguments(call, function, gen);
+    fprintf(gen->output, "    call $%s\n", function->value);
+}
+
+// nomilk: "nomilk f(...);" è una chiamata in coda e non apre un nuovo frame.
+// La ricorsione diretta riscrive i parametri e salta dopo il prologo, le
+// altre chiamate smontano il frame e saltano alla funzione
+static void generate_return(ASTNode* node, CodeGen* gen) {
+    FILE* output = gen->output;
+    ASTNode* value = node->left;
+
+    if (value && is_user_call(value)) {
+        ASTNode* function = find_function(gen, value->value);
+        if (!should_inline(gen, function)) {
+            int count = load_call_arguments(value, function, gen);
+            if (function == gen->current_function) {
+                ASTNode* parameter = function->left;
+                for (int i = 0; i < count; i++, parameter = parameter->next) {
+                    fprintf(output, "    mov [rbp-%d], %s ; %s\n",
+                            lookup_symbol(gen, parameter->value), argument_registers[i], parameter->value);
+                }
+                fprintf(output, "    jmp .L%d\n", gen->entry_label);
+            } else {
+                fprintf(output, "    leave\n");
+                fprintf(output, "    jmp $%s\n", function->value);
+            }
+            return;
+        }
+    }
+
+    if (value) {
+        generate_expression(value, gen);
+    } else {
+        fprintf(output, "    xor eax, eax\n");
+    }
+    fprintf(output, "    leave\n");
+    fprintf(output, "    ret\n");
+}
+
+// Nomi che collidono con i simboli generati dal compilatore
+static void check_function_name(const char* name) {
+    const char* suffix = name + 7;
+    int message_label = strncmp(name, "message", 7) == 0 && *suffix &&
+                        strspn(suffix, "0123456789") == strlen(suffix);
+    if (strcmp(name, "_start") == 0 || strncmp(name, "__ohio_", 7) == 0 || message_label) {
+        fprintf(stderr, "Errore: il nome '%s' è riservato al compilatore\n", name);
+        exit(1);
+    }
+}
+
+static void generate_function(ASTNode* function, CodeGen* gen) {
+    FILE* output = gen->output;
+    check_function_name(function->value);
+
+    // Parametri nei primi slot, poi le variabili locali e i temporanei inline
+    reset_symbols(gen);
+    int parameter_count = 0; // Al massimo MAX_CALL_ARGUMENTS, controllato dal parser
+    for (ASTNode* parameter = function->left; parameter; parameter = parameter->next) {
+        declare_symbol(gen, parameter->value);
+        parameter_count++;
+    }
+    collect_locals(function->right, gen);
+    int temps = inline_temps_needed(function->right, gen);
+    for (int i = 0; i < temps; i++) declare_symbol(gen, inline_temp_name(i));
+    int frame_size = (gen->symbol_count * 8 + 15) & ~15;
+
+    char symbol[MAX_TOKEN_LENGTH + 1];
+    snprintf(symbol, sizeof(symbol), "$%s", function->value); // $: il nome può coincidere con un'istruzione
+    emit_source_line(gen, function);
+    begin_function(gen, symbol);
+    fprintf(output, "    push rbp\n");
+    fprintf(output, "    mov rbp, rsp\n");
+    if (frame_size) fprintf(output, "    sub rsp, %d\n", frame_size);
+    ASTNode* parameter = function->left;
+    for (int i = 0; i < parameter_count; i++, parameter = parameter->next) {
+        fprintf(output, "    mov [rbp-%d], %s ; %s\n", lookup_symbol(gen, parameter->value), argument_registers[i], parameter->value);
+    }
+
+    gen->current_function = function;
+    gen->entry_label = new_label(gen);
+    fprintf(output, ".L%d:\n", gen->entry_label);
+    if (gen->profile_mode == PROFILE_GENERATE) emit_profile_counter(gen, function->profile_id);
+
+    generate_code(function->right, gen);
+    fprintf(output, "    xor eax, eax\n");
+    fprintf(output, "    leave\n");
+    fprintf(output, "    ret\n");
+    end_function(gen);
+    gen->current_function = NULL;
+}
+
+// Decodifica le sequenze di escape di un letterale .ohio; restituisce la lunghezza
+static size_t decode_escapes(const char* raw, char* out) {
+    size_t length = 0;
+    for (const char* c = raw; *c; c++) {
+        if (*c != '\\' || !c[1]) {
+            out[length++] = *c;
+            continue;
+        }
+        switch (*++c) {
+            case 'n': out[length++] = '\n'; break;
+            case 't': out[length++] = '\t'; break;
+            case 'r': out[length++] = '\r'; break;
+            case '0': out[length++] = '\0'; break;
+            default:  out[length++] = *c; break; // \\ \" e tutto il resto
+        }
+    }
+    return length;
+}
+
+static ASTNode* format_argument(ASTNode* argument, const char* function) {
+    if (!argument) {
+        fprintf(stderr, "Errore: argomenti insufficienti per il formato di %s\n", function);
+        exit(1);
+    }
+    return argument;
+}
+
+// Emette il testo letterale accumulato con un'unica chiamata
+static void flush_literal(CodeGen* gen, char* text, size_t* length) {
+    if (*length == 1) {
+        fprintf(gen->output, "    mov edi, %d\n", (unsigned char)text[0]);
+        fprintf(gen->output, "    call __ohio_write_char\n");
+    } else if (*length > 1) {
+        int index = add_message(gen, text, *length);
+        fprintf(gen->output, "    mov rsi, message%d\n", index);
+        fprintf(gen->output, "    mov rdx, %zu\n", *length);
+        fprintf(gen->output, "    call __ohio_write_bytes\n");
+    }
+    *length = 0;
+}
+
+// Il carattere dopo '%' può mancare o non essere stampabile (es. "\0")
+static void unsupported_conversion(const char* function, int has_conversion, char conversion) {
+    if (!has_conversion) {
+        fprintf(stderr, "Errore: formato di %s terminato da '%%'\n", function);
+    } else if (isprint((unsigned char)conversion)) {
+        fprintf(stderr, "Errore: formato '%%%c' non supportato da %s\n", conversion, function);
+    } else {
+        fprintf(stderr, "Errore: formato '%%\\x%02x' non supportato da %s\n", (unsigned char)conversion, function);
+    }
+    exit(1);
+}
+
+// yapper: il formato è risolto a tempo di compilazione. Il testo fisso (anche
+// quello dei %s con letterali) diventa un'unica copia nel buffer, %d e %c
+// chiamano direttamente le routine di formattazione
+static void generate_yapper(ASTNode* node, CodeGen* gen) {
+    ASTNode* format = node->left;
+    if (!format || format->type != NODE_STRING) {
+        fprintf(stderr, "Errore: yapper richiede una stringa di formato\n");
+        exit(1);
+    }
+
+    char spec[MAX_TOKEN_LENGTH];
+    size_t spec_length = decode_escapes(format->value, spec);
+    char literal[MAX_TOKEN_LENGTH * MAX_TOKEN_LENGTH];
+    size_t literal_length = 0;
+    ASTNode* argument = format->next;
+
+    for (size_t i = 0; i < spec_length; i++) {
+        if (spec[i] != '%') {
+            literal[literal_length++] = spec[i];
+            continue;
+        }
+
+        while (i + 1 < spec_length && spec[i + 1] == 'l') i++; // %ld, %lld: gli interi sono già a 64 bit
+        int has_conversion = i + 1 < spec_length;
+        char conversion = has_conversion ? spec[++i] : '\0';
+        switch (conversion) {
+            case '%':
+                literal[literal_length++] = '%';
+                break;
+
+            case 's': {
+                argument = format_argument(argument, "yapper");
+                if (argument->type != NODE_STRING) {
+                    fprintf(stderr, "Errore: %%s di yapper accetta solo stringhe letterali\n");
+                    exit(1);
+                }
+                char text[MAX_TOKEN_LENGTH];
+                size_t length = decode_escapes(argument->value, text);
+                if (literal_length + length > sizeof(literal)) flush_literal(gen, literal, &literal_length);
+                memcpy(literal + literal_length, text, length);
+                literal_length += length;
+                argument = argument->next;
+                break;
+            }
+
+            case 'd':
+            case 'i':
+            case 'c':
+                argument = format_argument(argument, "yapper");
+                flush_literal(gen, literal, &literal_length);
+                generate_expression(argument, gen);
+                fprintf(gen->output, "    mov rdi, rax\n");
+                fprintf(gen->output, "    call %s\n", conversion == 'c' ? "__ohio_write_char" : "__ohio_write_int");
+                argument = argument->next;
+                break;
+
+            default:
+                unsupported_conversion("yapper", has_conversion, conversion);
+        }
+    }
+    flush_literal(gen, literal, &literal_length);
+
+    if (argument) {
+        fprintf(stderr, "Errore: troppi argomenti per il formato di yapper\n");
+        exit(1);
+    }
+}
+
+// caseoh_fun: %d e %c leggono nelle variabili indicate, gli spazi nel formato
+// sono ignorati (la lettura degli interi salta comunque gli spazi bianchi)
+static void generate_caseoh_fun(ASTNode* node, CodeGen* gen) {
+    ASTNode* format = node->left;
+    if (!format || format->type != NODE_STRING) {
+        fprintf(stderr, "Errore: caseoh_fun richiede una stringa di formato\n");
+        exit(1);
+    }
+
+    char spec[MAX_TOKEN_LENGTH];
+    size_t spec_length = decode_escapes(format->value, spec);
+    ASTNode* argument = format->next;
+
+    for (size_t i = 0; i < spec_length; i++) {
+        if (isspace((unsigned char)spec[i])) continue;
+        if (spec[i] != '%') {
+            fprintf(stderr, "Errore: caseoh_fun non supporta caratteri letterali nel formato ('%c')\n", spec[i]);
+            exit(1);
+        }
+
+        while (i + 1 < spec_length && spec[i + 1] == 'l') i++;
+        int has_conversion = i + 1 < spec_length;
+        char conversion = has_conversion ? spec[++i] : '\0';
+        if (conversion != 'd' && conversion != 'i' && conversion != 'c') {
+            unsupported_conversion("caseoh_fun", has_conversion, conversion);
+        }
+
+        argument = format_argument(argument, "caseoh_fun");
+        if (argument->type != NODE_IDENTIFIER) {
+            fprintf(stderr, "Errore: caseoh_fun richiede variabili come argomenti\n");
+            exit(1);
+        }
+        fprintf(gen->output, "    call %s\n", conversion == 'c' ? "__ohio_read_char" : "__ohio_read_int");
+        fprintf(gen->output, "    mov [rbp-%d], rax ; %s\n", lookup_symbol(gen, argument->value), argument->value);
+        argument = argument->next;
+    }
+
+    if (argument) {
+        fprintf(stderr, "Errore: troppi argomenti per il formato di caseoh_fun\n");
+        exit(1);
+    }
+}
+
+// Blocco spostato fuori linea: al termine torna a return_label
+static void generate_cold_block(CodeGen* gen, int label, ASTNode* body, int return_label) {
+    begin_cold(gen);
+    fprintf(gen->output, ".L%d:\n", label);
+    generate_code(body, gen);
+    fprintf(gen->output, "    jmp .L%d\n", return_label);
+    end_cold(gen);
+}
+
+// beta/sigma: con un profilo il ramo più eseguito diventa il fall-through
+// e quello freddo finisce fuori linea
+static void generate_if(ASTNode* node, CodeGen* gen) {
+    FILE* output = gen->output;
+    ASTNode* then_body = node->right;
+    ASTNode* else_body = node->alternate;
+    int end = new_label(gen);
+    int other = new_label(gen);
+
+    unsigned long long total, then_count;
+    if (profile_counts(gen, node, &total, &then_count) && !gen->in_cold_section) {
+        unsigned long long else_count = total - then_count;
+
+        if (then_count >= else_count) {
+            if (else_body && is_cold(else_count, then_count)) {
+                generate_branch(node->left, gen, 0, other);
+                generate_code(then_body, gen);
+                fprintf(output, ".L%d:\n", end);
+                generate_cold_block(gen, other, else_body, end);
+                return;
+            }
+        } else if (else_body || is_cold(then_count, else_count)) {
+            // Condizione invertita: il ramo sigma è quello caldo
+            generate_branch(node->left, gen, 1, other);
+            generate_code(else_body, gen);
+            if (is_cold(then_count, else_count)) {
+                fprintf(output, ".L%d:\n", end);
+                generate_cold_block(gen, other, then_body, end);
+            } else {
+                fprintf(output, "    jmp .L%d\n", end);
+                fprintf(output, ".L%d:\n", other);
+                generate_code(then_body, gen);
+                fprintf(output, ".L%d:\n", end);
+            }
+            return;
+        }
+    }
+
+    // Layout in ordine di sorgente
+    if (gen->profile_mode == PROFILE_GENERATE) emit_profile_counter(gen, node->profile_id);
+    generate_branch(node->left, gen, 0, else_body ? other : end);
+    if (gen->profile_mode == PROFILE_GENERATE) emit_profile_counter(gen, node->profile_id + 1);
+    generate_code(then_body, gen);
+    if (else_body) {
+        fprintf(output, "    jmp .L%d\n", end);
+        fprintf(output, ".L%d:\n", other);
+        generate_code(else_body, gen);
+    }
+    fprintf(output, ".L%d:\n", end);
+}
+
+// edging: con un profilo i cicli caldi vengono ruotati (un solo salto per
+// iterazione) e srotolati se il corpo è piccolo e le iterazioni molte
+static void generate_while(ASTNode* node, CodeGen* gen) {
+    FILE* output = gen->output;
+    int top = new_label(gen);
+    int body = new_label(gen);
+    int end = new_label(gen);
+
+    unsigned long long total, body_count;
+    if (profile_counts(gen, node, &total, &body_count)) {
+        if (body_count == 0 && !gen->in_cold_section) {
+            // Il corpo non è mai stato eseguito: resta solo il test sul percorso caldo
+            fprintf(output, ".L%d:\n", top);
+            generate_branch(node->left, gen, 1, body);
+            fprintf(output, ".L%d:\n", end);
+            generate_cold_block(gen, body, node->right, top);
+            return;
+        }
+
+        if (body_count > 0) {
+            unsigned long long trip_count = body_count / total;
+            int small = count_statements(node->right) <= UNROLL_MAX_STATEMENTS;
+            int unroll = !small ? 1 : trip_count >= UNROLL4_MIN_TRIP_COUNT ? 4 : trip_count >= UNROLL_MIN_TRIP_COUNT ? 2 : 1;
+
+            fprintf(output, "    jmp .L%d\n", top);
+            fprintf(output, ".L%d:\n", body);
+            for (int i = 0; i < unroll; i++) {
+                if (i > 0) generate_branch(node->left, gen, 0, end);
+                generate_code(node->right, gen);
+            }
+            fprintf(output, ".L%d:\n", top);
+            generate_branch(node->left, gen, 1, body);
+            fprintf(output, ".L%d:\n", end);
+            return;
+        }
+    }
+
+    if (gen->profile_mode == PROFILE_GENERATE) emit_profile_counter(gen, node->profile_id);
+    fprintf(output, ".L%d:\n", top);
+    generate_branch(node->left, gen, 0, end);
+    if (gen->profile_mode == PROFILE_GENERATE) emit_profile_counter(gen, node->profile_id + 1);
+    generate_code(node->right, gen);
+    fprintf(output, "    jmp .L%d\n", top);
+    fprintf(output, ".L%d:\n", end);
+}
+
+// Generazione del codice per una lista di statement
+void generate_code(ASTNode* node, CodeGen* gen) {
+    FILE* output = gen->output;
+
+    // Le liste di statement possono essere lunghissime: niente ricorsione su next
+    for (; node; node = node->next) {
+        if (node->type != NODE_PROGRAM) emit_source_line(gen, node);
+
+        switch (node->type) {
+            case NODE_PROGRAM:
+                gen->functions = node->left;
+
+                // Il runtime precede il primo %line: resta attribuito al .asm
+                fprintf(output, "section .text\n");
+                if (gen->io_runtime) emit_runtime(gen);
+                emit_source_line(gen, node);
+                begin_function(gen, "_start");
+                fprintf(output, "    call $main\n");
+                fprintf(output, "    mov rbx, rax ; il valore di main diventa il codice di uscita\n");
+                if (gen->io_runtime) fprintf(output, "    call __ohio_flush\n");
+                if (gen->profile_mode == PROFILE_GENERATE) emit_profile_dump(gen);
+                fprintf(output, "    mov rax, 60 ; sys_exit\n");
+                fprintf(output, "    mov rdi, rbx\n");
+                fprintf(output, "    syscall\n");
+                end_function(gen);
+
+                for (ASTNode* function = node->left; function; function = function->next) {
+                    generate_function(function, gen);
+                }
+
+                // I messaggi sono noti solo dopo aver generato il corpo
+                fprintf(output, "\nsection .data\n");
+                for (int i = 0; i < gen->message_count; i++) {
+                    emit_message(output, i, &gen->messages[i]);
+                }
+                if (gen->profile_mode == PROFILE_GENERATE) emit_profile_data(gen);
+                if (gen->io_runtime) emit_runtime_data(output);
+                break;
+
+            case NODE_DECLARATION:
+                if (node->left) {
+                    generate_expression(node->left, gen);
+                    fprintf(output, "    mov [rbp-%d], rax ; %s\n", lookup_symbol(gen, node->value), node->value);
+                } else {
+                    fprintf(output, "    mov qword [rbp-%d], 0 ; %s\n", lookup_symbol(gen, node->value), node->value);
+                }
+                break;
+
+            case NODE_ASSIGNMENT:
+                generate_expression(node->left, gen);
+                fprintf(output, "    mov [rbp-%d], rax ; %s\n", lookup_symbol(gen, node->value), node->value);
+                break;
+
+            case NODE_IF_STATEMENT:
+                generate_if(node, gen);
+                break;
+
+            case NODE_WHILE_LOOP:
+                generate_while(node, gen);
+                break;
+
+            case NODE_FUNCTION_CALL:
+                if (strcmp(node->value, "yapper") == 0) {
+                    generate_yapper(node, gen);
+                } else if (strcmp(node->value, "caseoh_fun") == 0) {
+                    generate_caseoh_fun(node, gen);
+                } else {
+                    generate_call(node, gen);
+                }
+                break;
+
+            case NODE_RETURN:
+                generate_return(node, gen);
+                break;
+
+            default:
+                fprintf(stderr, "Errore: Nodo non supportato\n");
+                exit(1);
+        }
+    }
+}
+
+void generate_program(ASTNode* ast, const char* output_file, const CompileOptions* options) {
     FILE* output = fopen(output_file, "w");
     if (!output) {
         perror("Errore nell'apertura del file di output");
         exit(1);
     }
 
-    char messages[MAX_MESSAGE_COUNT][MAX_TOKEN_LENGTH] = {"Hello, World!"};
-    int message_count = 1;
+    CodeGen gen = {0};
+    gen.output = output;
+    gen.profile_mode = options->profile_mode;
+    gen.profile_path = options->profile_path ? options->profile_path : DEFAULT_PROFILE_PATH;
+    gen.profile_checksum = FNV_OFFSET_BASIS;
+    gen.debug_info = options->debug_info && options->source_path;
+    gen.source_path = options->source_path;
+
+    gen.io_runtime = needs_io_runtime(ast);
+
+    assign_profile_ids(ast, &gen);
+    if (gen.profile_mode == PROFILE_USE) load_profile(&gen);
+
+    generate_code(ast, &gen);
 
-    generate_code(ast, output, messages, &message_count);
+    for (int i = 0; i < gen.message_count; i++) {
+        free(gen.messages[i].bytes);
+    }
+    free(gen.messages);
+    free(gen.symbols);
+    free(gen.profile_counts);
     fclose(output);
 }
 
+// Legge l'intero file sorgente in memoria (terminato da '\0')
+char* read_source(const char* path, size_t* out_length) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror("Errore nell'apertura del file sorgente");
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    size_t length = 0;
+    char* source = malloc(capacity);
+    size_t read;
+    while (source && (read = fread(source + length, 1, capacity - length - 1, file)) > 0) {
+        length += read;
+        if (capacity - length == 1) {
+            capacity *= 2;
+            source = realloc(source, capacity);
+        }
+    }
+    fclose(file);
+
+    if (!source) {
+        fprintf(stderr, "Errore: memoria esaurita\n");
+        return NULL;
+    }
+    source[length] = '\0';
+    if (out_length) *out_length = length;
+    return source;
+}
+
 // Main
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <source_file.ohio> <output_file.asm>\n", argv[0]);
-        return 1;
+    CompileOptions options = {PROFILE_NONE, NULL, 0, NULL};
+    const char* paths[2];
+    int path_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0) {
+            options.debug_info = 1;
+        } else if (strcmp(argv[i], "--profile-generate") == 0) {
+            options.profile_mode = PROFILE_GENERATE;
+        } else if (strncmp(argv[i], "--profile-generate=", 19) == 0) {
+            options.profile_mode = PROFILE_GENERATE;
+            options.profile_path = argv[i] + 19;
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0) {
+            options.profile_mode = PROFILE_USE;
+            options.profile_path = argv[i] + 14;
+        } else if (argv[i][0] != '-' && path_count < 2) {
+            paths[path_count++] = argv[i];
+        } else {
+            path_count = -1;
+            break;
+        }
     }
 
-    FILE* file = fopen(argv[1], "r");
-    if (!file) {
-        perror("Errore nell'apertura del file sorgente");
+    if (path_count != 2) {
+        fprintf(stderr, "Usage: %s [-g] [--profile-generate[=file] | --profile-use=file] <source_file.ohio> <output_file.asm>\n", argv[0]);
         return 1;
     }
 
-    char* source = malloc(MAX_SOURCE_LENGTH);
-    size_t length = fread(source, 1, MAX_SOURCE_LENGTH - 1, file);
-    fclose(file);
-    source[length] = '\0';
+    char* source = read_source(paths[0], NULL);
+    if (!source) return 1;
+    options.source_path = paths[0];
 
     Lexer lexer = create_lexer(source);
     ASTNode* program = parse_program(&lexer);
-    generate_program(program, argv[2]);
+    generate_program(program, paths[1], &options);
 
+    free_ast(program);
     free(source);
     return 0;
 }